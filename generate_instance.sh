@@ -13,4 +13,4 @@ MIN_DEG=1
 MAX_DEG=$1
 
 pgsolver/bin/randomgame $NUM_NODES $MAX_PRIORITY $MIN_DEG $MAX_DEG > $PG_WRITE_TO_FILE
-bin/pg2mpg $PG_WRITE_TO_FILE $MAX_WEIGHT
+bin/pg2mpg $PG_WRITE_TO_FILE $MAX_WEIGHT $3 # optional output file, binary if it ends with ".bin"
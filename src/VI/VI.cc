@@ -21,160 +21,248 @@
 */
 
 #include <iostream>
-#include <list>
+#include <string>
 #include <utility>
 #include <climits>
+#include <limits>
+#include <type_traits>
 #include <assert.h>
 #include "math.h"
 #include "VI.h"
+#include "worklist.h"
+#include "VIsimd.h"
 
 using namespace std;
 
-unsigned long circle_op(MeanPayoffGame *mpg, long a, long b);
-void lift_op(MeanPayoffGame *mpg, t_nrg* e, t_idx v);
-list<pair<unsigned long, long> >* compute_pre_arcs(MeanPayoffGame *mpg);
-long get_count(MeanPayoffGame *mpg, t_nrg* e, t_idx v);
+// lifts between two polls of the budget of the solve
+#define VI_POLL_PERIOD 1024
+
+template<typename I, typename W, typename WL> static t_status VI_iterate(MeanPayoffGame *mpg, I *energy, WL& L, SolverWorkspace* ws, const t_vi_conf& conf);
 
 // compute decision boolean vector
-void VI_solve_decision(MeanPayoffGame *mpg, bool *decision){
+t_status VI_solve_decision(MeanPayoffGame *mpg, bool *decision, const t_vi_conf& conf){
 	t_idx size = mpg->get_n_0() + mpg->get_n_1();
-	t_nrg energy[size]; 
-	VI_compute_energy(mpg, energy);
+	SolverWorkspace local;
+	t_vi_conf c = conf;
+	if(c.workspace == NULL) c.workspace = &local;
+	t_nrg* energy = c.workspace->get<t_nrg>(WS_ENERGY, size);
+	t_status status = VI_compute_energy(mpg, energy, c);
 	for(t_idx u=0; u < size; u++){
 		if(energy[u]==ULONG_MAX) decision[u]=false;
 		else decision[u]=true;
 	}
-}
-
-// computes a pre-arcs list
-list<pair<t_idx, t_weight> >* compute_pre_arcs(MeanPayoffGame *mpg){
-	t_idx size = mpg->get_n_0() + mpg->get_n_1();
-	list<pair<t_idx, t_weight> >* pre_arcs = new list<pair<t_idx, t_weight> >[size];
-	for(t_idx u=0; u < size; u++){
-		list<t_w_arc>* arc_list = mpg->get_arcs(u);
-		list<t_w_arc>::iterator it = arc_list->begin();
-		for(it; it != arc_list->end(); it++){
-			t_w_arc arc = *it;
-			t_idx head_idx = arc.head_idx;
-			t_weight weight = arc.weight;
-			pair<t_idx, t_weight> p(u, weight);
-			pre_arcs[head_idx].push_front(p);
-		}
-	}
-	return pre_arcs;
-}
-
-// computes the circle-minus operator, see [Brim2011], we assumee ULONG_MAX=\top
-t_nrg circle_op(MeanPayoffGame *mpg, long a, long b){
-	if(a == ULONG_MAX || (a>b && a - b > mpg->get_Top())) return ULONG_MAX;
-	return a>b ? a-b : 0;
+	return status;
 }
 
 // computes updated value for the count(f,v) function
 // pre-condition: u is a Max node
-long get_count(MeanPayoffGame *mpg, t_nrg* energy, t_idx u){
-	if(u < mpg->get_n_0()) throw "u is a Min node, count() is undefined";
+template<typename I, typename W>
+long get_count(const t_csr<I, W>* csr, t_idx n_0, t_nrg Top, I* energy, I u){
+	if(u < n_0) throw "u is a Min node, count() is undefined";
+	if constexpr(is_same<I, uint32_t>::value){ // vectorised on high degree vertices
+		I deg = csr->offset[u+1] - csr->offset[u];
+		if(deg >= SIMD_MIN_DEG && csr->n <= INT32_MAX)
+			return count_kernel32(csr->head + csr->offset[u], csr->weight + csr->offset[u], deg, energy, Top, energy[u]);
+	}
 	unsigned long count = 0;
-	list<t_w_arc>* arc_list = mpg->get_arcs(u);
-	list<t_w_arc>::iterator it = arc_list->begin();
-	for(it; it!=arc_list->end(); it++){
-		t_w_arc arc = *it;
-		t_idx v = arc.head_idx;
-		t_weight weight = arc.weight;
-		t_nrg rhs = circle_op(mpg, energy[v], weight);
+	for(I a=csr->offset[u]; a < csr->offset[u+1]; a++){
+		I v = csr->head[a];
+		W weight = csr->weight[a];
+		I rhs = circle_op(Top, energy[v], weight);
 		if(energy[u] >= rhs) count++;
 	}
 	return count;
 }
 
 // computes the lift operator delta(f,v), see [Brim2011]
-void lift_op(MeanPayoffGame *mpg, t_nrg* energy, t_idx u){
-	t_idx n_0 = mpg->get_n_0();
-	t_nrg lifted_val = u<n_0 ? 0 : ULONG_MAX;
-	list<t_w_arc>* arc_list = mpg->get_arcs(u);
-	list<t_w_arc>::iterator it = arc_list->begin();
-	for(it; it!=arc_list->end(); it++){
-		t_w_arc arc = *it;
-		t_idx v = arc.head_idx;
-		t_weight weight = arc.weight;
-		t_nrg candidate = circle_op(mpg, energy[v], weight);
+template<typename I, typename W>
+void lift_op(const t_csr<I, W>* csr, t_idx n_0, t_nrg Top, I* energy, I u){
+	const I top = numeric_limits<I>::max();
+	if constexpr(is_same<I, uint32_t>::value){ // vectorised on high degree vertices
+		I deg = csr->offset[u+1] - csr->offset[u];
+		if(deg >= SIMD_MIN_DEG && csr->n <= INT32_MAX){
+			energy[u] = lift_kernel32(csr->head + csr->offset[u], csr->weight + csr->offset[u], deg, energy, Top, u >= n_0);
+			return;
+		}
+	}
+	I lifted_val = u<n_0 ? 0 : top;
+	for(I a=csr->offset[u]; a < csr->offset[u+1]; a++){
+		I v = csr->head[a];
+		W weight = csr->weight[a];
+		I candidate = circle_op(Top, energy[v], weight);
 		if((u < n_0 && candidate > lifted_val) || 
 			(u >= n_0 && candidate < lifted_val))
 			lifted_val = candidate;
 	}
-	if(lifted_val > mpg->get_Top()) energy[u] = ULONG_MAX;
+	if(lifted_val > Top) energy[u] = top;
 	else energy[u] = lifted_val;
 }
 
+// Value Iteration Algorithm for Energy Games, computes energies of the
+// storage width of @mpg, I=uint32_t and W=int32_t for 32-bit games
+t_status VI_compute_energy(MeanPayoffGame *mpg, t_nrg *energy, const t_vi_conf& conf){
+	if(mpg->get_width() == WIDTH_64)
+		return VI_compute_energy<t_idx, t_weight>(mpg, energy, conf);
+	t_idx size = mpg->get_n_0() + mpg->get_n_1();
+	SolverWorkspace local;
+	t_vi_conf c = conf;
+	if(c.workspace == NULL) c.workspace = &local;
+	uint32_t* energy32 = c.workspace->get<uint32_t>(WS_ENERGY_NARROW, size);
+	if(c.warm_start) narrow_energy(energy, energy32, size);
+	t_mem_report mem;
+	if(c.memory != NULL) c.memory = &mem;
+	t_status status = VI_compute_energy<uint32_t, int32_t>(mpg, energy32, c);
+	widen_energy(energy32, energy, size);
+	mem.bytes[MEM_ARRAYS] += size * sizeof(t_nrg); // the energies of the caller
+	if(conf.memory != NULL) conf.memory->peak(mem);
+	return status;
+}
+
+// Value Iteration Algorithm for Energy Games, dispatches on the number of threads
+// and on the worklist policy
+template<typename I, typename W>
+t_status VI_compute_energy(MeanPayoffGame *mpg, I *energy, const t_vi_conf& conf){
+	I n_0 = mpg->get_n_0();
+	I size = n_0 + mpg->get_n_1();
+	SolverWorkspace local;
+	SolverWorkspace* ws = conf.workspace != NULL ? conf.workspace : &local;
+	if(conf.threads != 1){
+		t_vi_conf c = conf;
+		c.workspace = ws;
+		return VI_compute_energy_parallel<I, W>(mpg, energy, c);
+	}
+	t_status status;
+	switch(conf.policy){
+		case VI_LIFO:{
+			LifoWorklist<I> L(n_0, size, ws);
+			status = VI_iterate<I, W>(mpg, energy, L, ws, conf);
+		}break;
+		case VI_FIFO:{
+			FifoWorklist<I> L(n_0, size, ws);
+			status = VI_iterate<I, W>(mpg, energy, L, ws, conf);
+		}break;
+		case VI_PRIORITY:{
+			PriorityWorklist<I> L(n_0, size, ws);
+			status = VI_iterate<I, W>(mpg, energy, L, ws, conf);
+		}break;
+		case VI_MIN_FIRST:
+		case VI_MAX_FIRST:{
+			TwoQueueWorklist<I> L(n_0, size, conf.policy == VI_MAX_FIRST ? MAX : MIN, ws);
+			status = VI_iterate<I, W>(mpg, energy, L, ws, conf);
+		}break;
+		default: throw "unknown VI worklist policy";
+	}
+	if(conf.memory != NULL){
+		t_mem_report mem;
+		mpg->memory(&mem);
+		mem.bytes[MEM_ARRAYS] = size * sizeof(I) + ws->footprint(WS_COUNT);
+		mem.bytes[MEM_QUEUES] = ws->footprint(WS_IN_LIST) + ws->footprint(WS_LIST);
+		if(conf.policy == VI_MIN_FIRST || conf.policy == VI_MAX_FIRST) mem.bytes[MEM_QUEUES] += ws->footprint(WS_LIST2);
+		mem_report(conf.memory, mem);
+	}
+	return status;
+}
+
 // Value Iteration Algorithm for Energy Games, main loop, see [Brim2011].
-void VI_compute_energy(MeanPayoffGame *mpg, t_nrg *energy){
-	t_idx n_0 = mpg->get_n_0();
-	t_idx n_1 = mpg->get_n_1();
-	t_idx size = n_0 + n_1;
-	fill_n(energy, size, 0);
-	long* count = new long[size];
-	// compute pre arc lists
-	list<pair<t_idx, t_weight> >* pre_arcs = compute_pre_arcs(mpg);
-	// init list L
-	list<t_idx> L;
-	bool contains[size];
-	for(t_idx u=0; u < size; u++){
-		list<t_w_arc>* arc_list = mpg->get_arcs(u);
-		list<t_w_arc>::iterator it = arc_list->begin();
-		bool insert = u < n_0 ? false : true;
-		for(it; it!=arc_list->end(); it++){
-			t_w_arc arc = *it;
-			if(u < n_0 && arc.weight < 0){ 
-				insert = true;
-				break;
-			}else if(u >= n_0 && arc.weight >= 0){
+// \top is the max value of I, @L is an empty worklist. A warm start iterates
+// from the energies in @energy with every vertex in L, instead of from 0
+template<typename I, typename W, typename WL>
+static t_status VI_iterate(MeanPayoffGame *mpg, I *energy, WL& L, SolverWorkspace* ws, const t_vi_conf& conf){
+	typedef typename make_signed<I>::type t_count;
+	I n_0 = mpg->get_n_0();
+	I n_1 = mpg->get_n_1();
+	I size = n_0 + n_1;
+	t_nrg Top = mpg->get_Top();
+	bool warm = conf.warm_start;
+	if(!warm) fill_n(energy, size, 0);
+	t_count* count = ws->get<t_count>(WS_COUNT, size);
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	// pre arcs are read from the game's reverse index
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
+	t_solve_stats stats;
+	// init worklist L
+	for(I u=0; u < size; u++){
+		bool insert = warm || (u < n_0 ? mpg->get_max_neg(u) > 0 : true);
+		for(I a=csr->offset[u]; !warm && u >= n_0 && a < csr->offset[u+1]; a++){
+			if(csr->weight[a] >= 0){
 				insert = false;
 				break;
 			}
 		}
 		if(insert){
-			L.push_front(u); // LIFO 
-		//	L.push_back(u); //FIFO
-			contains[u]=true;
-		}else contains[u]=false;
+			L.push(u, 0);
+			STAT_INC(stats, STAT_VI_PUSHES);
+		}
 	}
-	// init energy and counter
-	for(t_idx u=0; u < size; u++) energy[u] = 0;
-	for(t_idx u=0; u < size; u++){
+	// init counter
+	for(I u=0; u < size; u++){
 		count[u] = 0;
-		if(u >= n_0 && !contains[u]) count[u] = get_count(mpg, energy, u);	
+		if(u >= n_0 && !L.contains(u)){
+			count[u] = get_count(csr, n_0, Top, energy, u);
+			STAT_ADD(stats, STAT_VI_CIRCLE_OPS, csr->offset[u+1] - csr->offset[u]);
+		}
 	}
 
 	//iterate until L goes empty
+	SolveBudget budget(conf.cancel, conf.deadline, VI_POLL_PERIOD);
+	t_status status = SOLVE_CONVERGED;
 	while(!L.empty()){
-		t_idx v = L.front(); // LIFO/FIFO
-		L.pop_front(); contains[v]=false; // LIFO/FIFO
-		t_nrg old = energy[v];
-		lift_op(mpg, energy, v);
+		if(budget.expired()){ // the energies only rise towards the least fixpoint
+			status = budget.get_status();
+			break;
+		}
+		I v = L.pop();
+		I old = energy[v];
+		lift_op(csr, n_0, Top, energy, v);
+		if(energy[v] < old) energy[v] = old; // a warm start may lie strictly above its lift
+		STAT_INC(stats, STAT_VI_POPS);
+		STAT_ADD(stats, STAT_VI_CIRCLE_OPS, (v >= n_0 ? 2 : 1) * (csr->offset[v+1] - csr->offset[v])); // lift and count
+		STAT_ADD(stats, STAT_VI_LIFTS, energy[v] > old);
+		STAT_ADD(stats, STAT_VI_TOP_SATURATIONS, energy[v] == numeric_limits<I>::max() && old != energy[v]);
 		//if(energy[v]==ULONG_MAX) break; // STOP CRITERION at first Min Node
-		if(v>=n_0) count[v] = get_count(mpg, energy, v);
-		list<pair<t_idx, t_weight> >::iterator it = pre_arcs[v].begin();
-		for(it; it!=pre_arcs[v].end(); it++){
-			pair<t_idx, t_weight> p = *it;
-			t_idx tail = p.first;
-			t_weight weight = p.second;
-			if(energy[tail] < circle_op(mpg, energy[v], weight)){
-				if(tail < n_0 && contains[tail]==false){ // check Min
-					L.push_front(tail); // add Min node LIFO
-					//L.push_back(tail); // FIFO
-					contains[tail]=true;
+		if(v>=n_0) count[v] = get_count(csr, n_0, Top, energy, v);
+		for(I i=rev->offset[v]; i < rev->offset[v+1]; i++){
+			I tail = rev->tail[i];
+			W weight = rev->weight[i];
+			STAT_INC(stats, STAT_VI_CIRCLE_OPS);
+			if(energy[tail] < circle_op(Top, energy[v], weight)){
+				if(tail < n_0 && !L.contains(tail)){ // check Min
+					L.push(tail, energy[tail]); // add Min node
+					STAT_INC(stats, STAT_VI_PUSHES);
 				}else if(tail >= n_0){ // check Max
-					if(energy[tail] >= circle_op(mpg, old, weight)) 
+					STAT_INC(stats, STAT_VI_CIRCLE_OPS);
+					if(energy[tail] >= circle_op(Top, old, weight)){
 						count[tail]--;
-					if(count[tail]<=0 && contains[tail]==false){
-						L.push_front(tail); // LIFO
-						//L.push_back(tail); // FIFO
-						contains[tail]=true;
+						STAT_INC(stats, STAT_VI_COUNT_DECREMENTS);
+					}
+					if(count[tail]<=0 && !L.contains(tail)){
+						L.push(tail, energy[tail]);
+						STAT_INC(stats, STAT_VI_PUSHES);
 					}
 				}
 			}
 		}
 	}
-	delete [] pre_arcs;
-	delete [] count;  
+	STAT_REPORT(conf.stats, stats);
+	return status;
+}
+
+static const char* VI_POLICY_NAMES[VI_NUM_POLICIES] = {"lifo", "fifo", "priority", "min_first", "max_first"};
+
+t_vi_policy VI_policy_from_string(const char* name){
+	for(int p=0; p < VI_NUM_POLICIES; p++)
+		if(string(name) == VI_POLICY_NAMES[p]) return (t_vi_policy) p;
+	throw "unknown VI worklist policy";
+}
+
+const char* VI_policy_name(t_vi_policy policy){
+	assert(policy < VI_NUM_POLICIES);
+	return VI_POLICY_NAMES[policy];
 }
+
+template t_status VI_compute_energy<uint32_t, int32_t>(MeanPayoffGame *mpg, uint32_t *energy, const t_vi_conf& conf);
+template t_status VI_compute_energy<t_idx, t_weight>(MeanPayoffGame *mpg, t_idx *energy, const t_vi_conf& conf);
+template void lift_op<uint32_t, int32_t>(const t_csr<uint32_t, int32_t>* csr, t_idx n_0, t_nrg Top, uint32_t* energy, uint32_t v);
+template void lift_op<t_idx, t_weight>(const t_csr<t_idx, t_weight>* csr, t_idx n_0, t_nrg Top, t_idx* energy, t_idx v);
+template long get_count<uint32_t, int32_t>(const t_csr<uint32_t, int32_t>* csr, t_idx n_0, t_nrg Top, uint32_t* energy, uint32_t v);
+template long get_count<t_idx, t_weight>(const t_csr<t_idx, t_weight>* csr, t_idx n_0, t_nrg Top, t_idx* energy, t_idx v);
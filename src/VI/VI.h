@@ -25,8 +25,51 @@
 
 #include "../mpg/mpg.h"
 #include "../conf.h"
+#include "../workspace/workspace.h"
+#include "../budget/budget.h"
+#include "../stats/stats.h"
 
-void VI_compute_energy(MeanPayoffGame *mpg, t_nrg* energy);
-void VI_solve_decision(MeanPayoffGame *mpg, bool* decision);
+// scheduling policies of the worklist of the main loop, see worklist.h
+enum t_vi_policy{
+	VI_LIFO=0, // stack 
+	VI_FIFO, // queue
+	VI_PRIORITY, // smallest energy first, bucketed by bit length
+	VI_MIN_FIRST, // one queue per player, Min vertices first
+	VI_MAX_FIRST, // one queue per player, Max vertices first
+	VI_NUM_POLICIES
+};
+
+// options of VI_compute_energy
+struct t_vi_conf{
+	t_vi_policy policy = VI_LIFO; // ignored by the multi-threaded VI
+	unsigned int threads = 1; // > 1 runs the multi-threaded VI, 0 uses all the cores
+	SolverWorkspace* workspace = NULL; // scratch buffers, NULL allocates them for the solve
+	bool warm_start = false; // the iteration starts from @energy, which must lie below the least fixpoint
+	const bool* cancel = NULL; // polled by the solve, which stops early once *cancel is set
+	t_deadline deadline = NO_DEADLINE; // the solve stops early once it is past, see budget.h
+	t_solve_stats* stats = NULL; // if not NULL, the counters of the solve are added to it, see stats.h
+	t_mem_report* memory = NULL; // if not NULL, it is raised to the footprint of the solve, see mem.h
+};
+
+// returns the policy named @name ("lifo", "fifo", "priority", "min_first", "max_first")
+t_vi_policy VI_policy_from_string(const char* name);
+const char* VI_policy_name(t_vi_policy policy);
+
+// energies of width I, the game must be stored with the same width (I,W)
+// the energies of a solve stopped early by @conf.cancel or @conf.deadline are below the least fixpoint
+template<typename I, typename W> 
+t_status VI_compute_energy(MeanPayoffGame *mpg, I* energy, const t_vi_conf& conf = t_vi_conf());
+// multi-threaded chaotic VI, see VIpar.cc, same result as VI_compute_energy
+template<typename I, typename W> 
+t_status VI_compute_energy_parallel(MeanPayoffGame *mpg, I* energy, const t_vi_conf& conf);
+// energies of width t_nrg, ULONG_MAX stands for \top
+t_status VI_compute_energy(MeanPayoffGame *mpg, t_nrg* energy, const t_vi_conf& conf = t_vi_conf());
+// the decisions of a solve stopped early are not valid
+t_status VI_solve_decision(MeanPayoffGame *mpg, bool* decision, const t_vi_conf& conf = t_vi_conf());
+
+// kernels of the main loop, see [Brim2011]: lift_op sets @energy[@v] to the lift delta(f,v)
+// of the energies of width I, get_count returns count(f,v) of the Max vertex @v
+template<typename I, typename W> void lift_op(const t_csr<I, W>* csr, t_idx n_0, t_nrg Top, I* energy, I v);
+template<typename I, typename W> long get_count(const t_csr<I, W>* csr, t_idx n_0, t_nrg Top, I* energy, I v);
 
 #endif
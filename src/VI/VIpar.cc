@@ -0,0 +1,271 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Multi-threaded chaotic Value Iteration, see [Brim2011] for the sequential algorithm.
+*  Every thread pops vertices from its own LIFO worklist, or steals from the others
+*  when it is empty, and lifts them concurrently with the other threads.
+*  Energies only increase, so they are updated by compare-and-swap max, and the lift
+*  of a vertex reading energies that are being increased is still below the least
+*  fixpoint. The invariant is that a vertex not in any worklist and not being lifted
+*  is stable, so the threads stop at the least fixpoint when all worklists are empty.
+*  count[u] of a Max vertex u may only underestimate the number of arcs out of u that
+*  satisfy energy[u], which costs spurious lifts but never misses one: a thread lifting
+*  u recounts, and requeues u if a decrement of count[u] raced with the recount, which
+*  it detects by the per-vertex sequence number touched[u], or if the recount is 0: a
+*  successor raised between the lift and the recount may have seen the energy of u
+*  before the lift, found its arc unsatisfied already and not decremented count[u].
+*  All the shared accesses are sequentially consistent __atomic builtins.
+*****************************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <limits>
+#include <type_traits>
+#include <assert.h>
+#include "VI.h"
+
+using namespace std;
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+// iterations of a thread between two polls of the budget of the solve
+#define VI_PAR_POLL_PERIOD 256
+
+/* a worklist of a thread, the others steal from its front */
+template<typename I>
+struct t_par_worklist{
+	mutex lock;
+	vector<I> vertices;
+};
+
+/* the state shared by the threads */
+template<typename I, typename W>
+struct t_par_vi{
+	typedef typename make_signed<I>::type t_count;
+	const t_csr<I, W>* csr;
+	const t_rev_csr<I, W>* rev;
+	I n_0, size;
+	t_nrg Top;
+	I* energy;
+	t_count* count;
+	uint32_t* touched; // incremented before every decrement of count[u]
+	bool* in_list; // true iff the vertex is in a worklist
+	unsigned long pending; // number of vertices in a worklist or being lifted
+	unsigned int num_threads;
+	t_par_worklist<I>* lists;
+	const bool* cancel; // budget of the solve, see t_vi_conf
+	t_deadline deadline;
+	int status; // t_status of the first thread stopped early
+	vector<t_solve_stats> stats; // counters of each thread, see stats.h
+};
+
+// the lift operator delta(f,v) on the current energies, see [Brim2011]
+template<typename I, typename W>
+static I par_lift(t_par_vi<I, W>* s, I u){
+	const I top = numeric_limits<I>::max();
+	const t_csr<I, W>* csr = s->csr;
+	I lifted_val = u < s->n_0 ? 0 : top;
+	for(I a=csr->offset[u]; a < csr->offset[u+1]; a++){
+		I candidate = circle_op(s->Top, LOAD(s->energy[csr->head[a]]), csr->weight[a]);
+		if((u < s->n_0 && candidate > lifted_val) || (u >= s->n_0 && candidate < lifted_val))
+			lifted_val = candidate;
+	}
+	return lifted_val > s->Top ? top : lifted_val;
+}
+
+// number of arcs out of the Max vertex @u satisfied by energy @e_u
+template<typename I, typename W>
+static long par_count(t_par_vi<I, W>* s, I u, I e_u){
+	const t_csr<I, W>* csr = s->csr;
+	long count = 0;
+	for(I a=csr->offset[u]; a < csr->offset[u+1]; a++)
+		if(e_u >= circle_op(s->Top, LOAD(s->energy[csr->head[a]]), csr->weight[a])) count++;
+	return count;
+}
+
+// inserts @u in the worklist of thread @t, unless it is already in a worklist
+template<typename I, typename W>
+static void par_push(t_par_vi<I, W>* s, unsigned int t, I u){
+	if(__atomic_exchange_n(&s->in_list[u], true, __ATOMIC_SEQ_CST)) return;
+	__atomic_add_fetch(&s->pending, 1, __ATOMIC_SEQ_CST);
+	STAT_INC(s->stats[t], STAT_VI_PUSHES);
+	lock_guard<mutex> guard(s->lists[t].lock);
+	s->lists[t].vertices.push_back(u);
+}
+
+// pops a vertex from the worklist of thread @t, or steals half of the worklist
+// of another thread, returns false if there is nothing to pop
+template<typename I, typename W>
+static bool par_pop(t_par_vi<I, W>* s, unsigned int t, I& u){
+	t_par_worklist<I>* own = &s->lists[t];
+	{
+		lock_guard<mutex> guard(own->lock);
+		if(!own->vertices.empty()){
+			u = own->vertices.back();
+			own->vertices.pop_back();
+			return true;
+		}
+	}
+	for(unsigned int i=1; i < s->num_threads; i++){
+		t_par_worklist<I>* victim = &s->lists[(t+i) % s->num_threads];
+		vector<I> stolen;
+		{
+			lock_guard<mutex> guard(victim->lock);
+			unsigned long len = victim->vertices.size();
+			if(len == 0) continue;
+			unsigned long half = (len + 1) / 2;
+			stolen.assign(victim->vertices.begin(), victim->vertices.begin() + half);
+			victim->vertices.erase(victim->vertices.begin(), victim->vertices.begin() + half);
+		}
+		u = stolen.back();
+		stolen.pop_back();
+		lock_guard<mutex> guard(own->lock);
+		own->vertices.insert(own->vertices.end(), stolen.begin(), stolen.end());
+		return true;
+	}
+	return false;
+}
+
+// lifts the popped vertex @v and propagates its increase to its predecessors
+template<typename I, typename W>
+static void par_lift_vertex(t_par_vi<I, W>* s, unsigned int t, I v){
+	const t_rev_csr<I, W>* rev = s->rev;
+	I n_0 = s->n_0;
+	__atomic_store_n(&s->in_list[v], false, __ATOMIC_SEQ_CST);
+	uint32_t seq = LOAD(s->touched[v]);
+	I lifted = par_lift(s, v);
+	I old = LOAD(s->energy[v]);
+	while(lifted > old && !__atomic_compare_exchange_n(&s->energy[v], &old, lifted,
+		false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+	STAT_INC(s->stats[t], STAT_VI_POPS);
+	STAT_ADD(s->stats[t], STAT_VI_CIRCLE_OPS, (v >= n_0 ? 2 : 1) * (s->csr->offset[v+1] - s->csr->offset[v])); // lift and count
+	STAT_ADD(s->stats[t], STAT_VI_LIFTS, lifted > old);
+	STAT_ADD(s->stats[t], STAT_VI_TOP_SATURATIONS, lifted > old && lifted == numeric_limits<I>::max());
+	if(v >= n_0){
+		I e_v = LOAD(s->energy[v]);
+		long count = par_count(s, v, e_v);
+		__atomic_store_n(&s->count[v], count, __ATOMIC_SEQ_CST);
+		if(count <= 0 || LOAD(s->touched[v]) != seq) par_push(s, t, v); // a decrement was missed or overwritten
+	}
+	if(lifted <= old) return;
+	for(I i=rev->offset[v]; i < rev->offset[v+1]; i++){
+		I tail = rev->tail[i];
+		W weight = rev->weight[i];
+		I e_tail = LOAD(s->energy[tail]);
+		STAT_INC(s->stats[t], STAT_VI_CIRCLE_OPS);
+		if(e_tail < circle_op(s->Top, lifted, weight)){
+			if(tail < n_0) par_push(s, t, tail); // check Min
+			else{ // check Max
+				STAT_INC(s->stats[t], STAT_VI_CIRCLE_OPS);
+				if(e_tail >= circle_op(s->Top, old, weight)){
+					STAT_INC(s->stats[t], STAT_VI_COUNT_DECREMENTS);
+					__atomic_add_fetch(&s->touched[tail], 1, __ATOMIC_SEQ_CST);
+					if(__atomic_sub_fetch(&s->count[tail], 1, __ATOMIC_SEQ_CST) <= 0)
+						par_push(s, t, tail);
+				}
+			}
+		}
+	}
+}
+
+// main loop of thread @t, which stops early when its budget expires: the
+// other threads may still steal the vertices of its worklist
+template<typename I, typename W>
+static void par_worker(t_par_vi<I, W>* s, unsigned int t){
+	SolveBudget budget(s->cancel, s->deadline, VI_PAR_POLL_PERIOD);
+	I v;
+	while(true){
+		if(budget.expired()){
+			int converged = SOLVE_CONVERGED;
+			__atomic_compare_exchange_n(&s->status, &converged, (int) budget.get_status(), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+			return;
+		}
+		if(par_pop(s, t, v)){
+			par_lift_vertex(s, t, v);
+			__atomic_sub_fetch(&s->pending, 1, __ATOMIC_SEQ_CST);
+		}else if(LOAD(s->pending) == 0) return;
+		else this_thread::yield();
+	}
+}
+
+// Value Iteration Algorithm for Energy Games with @conf.threads threads,
+// \top is the max value of I
+template<typename I, typename W>
+t_status VI_compute_energy_parallel(MeanPayoffGame *mpg, I *energy, const t_vi_conf& conf){
+	t_par_vi<I, W> s;
+	s.n_0 = mpg->get_n_0();
+	s.size = s.n_0 + mpg->get_n_1();
+	s.Top = mpg->get_Top();
+	s.csr = mpg->get_csr<I, W>();
+	s.rev = mpg->get_rev_csr<I, W>(); // built before the threads start
+	s.energy = energy;
+	s.cancel = conf.cancel;
+	s.deadline = conf.deadline;
+	s.status = SOLVE_CONVERGED;
+	SolverWorkspace local;
+	SolverWorkspace* ws = conf.workspace != NULL ? conf.workspace : &local;
+	s.count = ws->get<typename t_par_vi<I, W>::t_count>(WS_COUNT, s.size);
+	s.touched = ws->get<uint32_t>(WS_TOUCHED, s.size);
+	s.in_list = ws->get<bool>(WS_IN_LIST, s.size);
+	s.num_threads = conf.threads > 0 ? conf.threads : thread::hardware_concurrency();
+	if(s.num_threads == 0) s.num_threads = 1;
+	s.lists = new t_par_worklist<I>[s.num_threads];
+	s.stats.resize(s.num_threads);
+	s.pending = 0;
+	if(!conf.warm_start) fill_n(energy, s.size, 0);
+	fill_n(s.touched, s.size, 0);
+	fill_n(s.in_list, s.size, false);
+	// init worklists, round robin
+	unsigned int t = 0;
+	for(I u=0; u < s.size; u++){
+		bool insert = conf.warm_start || (u < s.n_0 ? mpg->get_max_neg(u) > 0 : true);
+		for(I a=s.csr->offset[u]; !conf.warm_start && u >= s.n_0 && a < s.csr->offset[u+1]; a++){
+			if(s.csr->weight[a] >= 0){
+				insert = false;
+				break;
+			}
+		}
+		s.count[u] = 0;
+		if(insert){
+			par_push(&s, t, u);
+			t = (t + 1) % s.num_threads;
+		}else if(u >= s.n_0){
+			s.count[u] = par_count(&s, u, (I) 0);
+			STAT_ADD(s.stats[0], STAT_VI_CIRCLE_OPS, s.csr->offset[u+1] - s.csr->offset[u]);
+		}
+	}
+	vector<thread> threads;
+	for(unsigned int i=1; i < s.num_threads; i++) threads.push_back(thread(par_worker<I, W>, &s, i));
+	par_worker(&s, 0);
+	for(unsigned int i=0; i < threads.size(); i++) threads[i].join();
+	if(conf.memory != NULL){
+		t_mem_report mem;
+		mpg->memory(&mem);
+		mem.bytes[MEM_ARRAYS] = s.size * sizeof(I) + ws->footprint(WS_COUNT) + ws->footprint(WS_TOUCHED);
+		mem.bytes[MEM_QUEUES] = ws->footprint(WS_IN_LIST) + s.num_threads * sizeof(t_par_worklist<I>);
+		for(unsigned int i=0; i < s.num_threads; i++) mem.bytes[MEM_QUEUES] += s.lists[i].vertices.capacity() * sizeof(I);
+		mem_report(conf.memory, mem);
+	}
+	delete [] s.lists;
+	for(unsigned int i=0; i < s.num_threads; i++) STAT_REPORT(conf.stats, s.stats[i]);
+	if(s.pending == 0) return SOLVE_CONVERGED; // the last threads emptied the worklists
+	assert(s.status != SOLVE_CONVERGED);
+	return (t_status) s.status;
+}
+
+template t_status VI_compute_energy_parallel<uint32_t, int32_t>(MeanPayoffGame *mpg, uint32_t *energy, const t_vi_conf& conf);
+template t_status VI_compute_energy_parallel<t_idx, t_weight>(MeanPayoffGame *mpg, t_idx *energy, const t_vi_conf& conf);
@@ -0,0 +1,207 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  AVX2 / AVX-512 kernels of the lift and count operators, see VIsimd.h.
+*  The kernels are compiled with per-function target attributes, so the rest of the
+*  program does not need -mavx2, and picked once at startup from the CPU features.
+*  On a block of arcs, e (-) w = max(0, e-w) is computed on 32-bit lanes as
+*  max(e,w)-w for w >= 0 and as e+|w| for w < 0, where an unsigned overflow or a
+*  result above Top saturates to \top, as does e = \top.
+*  Energies are gathered with signed 32-bit indexes, games with 2^31 vertices or more
+*  stay on the scalar kernels.
+*****************************************************************************************/
+
+#include <limits>
+#include <immintrin.h>
+#include "VIsimd.h"
+
+using namespace std;
+
+/* scalar kernels */
+
+static uint32_t lift_scalar(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, bool max_player){
+	uint32_t lifted_val = max_player ? UINT32_MAX : 0;
+	for(unsigned long a=0; a < deg; a++){
+		uint32_t candidate = circle_op(Top, energy[head[a]], weight[a]);
+		if((!max_player && candidate > lifted_val) || (max_player && candidate < lifted_val))
+			lifted_val = candidate;
+	}
+	return lifted_val;
+}
+
+static unsigned long count_scalar(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, uint32_t e_u){
+	unsigned long count = 0;
+	for(unsigned long a=0; a < deg; a++)
+		if(e_u >= circle_op(Top, energy[head[a]], weight[a])) count++;
+	return count;
+}
+
+/* AVX2 kernels, 8 arcs per step */
+
+// (-) on 8 arcs starting at @a
+__attribute__((target("avx2")))
+static inline __m256i circle_avx2(const uint32_t* head, const int32_t* weight, unsigned long a,
+	const uint32_t* energy, __m256i top, __m256i Top){
+	__m256i h = _mm256_loadu_si256((const __m256i*) (head + a));
+	__m256i w = _mm256_loadu_si256((const __m256i*) (weight + a));
+	__m256i e = _mm256_i32gather_epi32((const int*) energy, h, 4);
+	__m256i zero = _mm256_setzero_si256();
+	__m256i neg = _mm256_cmpgt_epi32(zero, w); // w < 0
+	__m256i sub = _mm256_sub_epi32(_mm256_max_epu32(e, w), w); // w >= 0
+	__m256i add = _mm256_sub_epi32(e, w); // e + |w|, w < 0
+	__m256i overflow = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(add, e), add), neg);
+	__m256i x = _mm256_blendv_epi8(sub, add, neg);
+	// x > Top iff max(x, Top) != Top
+	__m256i above = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(x, Top), Top),
+		_mm256_set1_epi32(-1));
+	__m256i saturate = _mm256_or_si256(_mm256_or_si256(overflow, above), _mm256_cmpeq_epi32(e, top));
+	return _mm256_blendv_epi8(x, top, saturate);
+}
+
+__attribute__((target("avx2")))
+static uint32_t lift_avx2(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, bool max_player){
+	__m256i top = _mm256_set1_epi32(-1);
+	__m256i v_Top = _mm256_set1_epi32(Top);
+	__m256i acc = max_player ? top : _mm256_setzero_si256();
+	unsigned long a = 0;
+	for(; a + 8 <= deg; a += 8){
+		__m256i c = circle_avx2(head, weight, a, energy, top, v_Top);
+		acc = max_player ? _mm256_min_epu32(acc, c) : _mm256_max_epu32(acc, c);
+	}
+	// horizontal min/max
+	__m128i r = max_player ?
+		_mm_min_epu32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)) :
+		_mm_max_epu32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+	__m128i s = _mm_shuffle_epi32(r, _MM_SHUFFLE(1, 0, 3, 2));
+	r = max_player ? _mm_min_epu32(r, s) : _mm_max_epu32(r, s);
+	s = _mm_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1));
+	r = max_player ? _mm_min_epu32(r, s) : _mm_max_epu32(r, s);
+	uint32_t lifted_val = _mm_cvtsi128_si32(r);
+	uint32_t tail = lift_scalar(head + a, weight + a, deg - a, energy, Top, max_player);
+	return max_player ? min(lifted_val, tail) : max(lifted_val, tail);
+}
+
+__attribute__((target("avx2,popcnt")))
+static unsigned long count_avx2(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, uint32_t e_u){
+	__m256i top = _mm256_set1_epi32(-1);
+	__m256i v_Top = _mm256_set1_epi32(Top);
+	__m256i v_e_u = _mm256_set1_epi32(e_u);
+	unsigned long count = 0;
+	unsigned long a = 0;
+	for(; a + 8 <= deg; a += 8){
+		__m256i c = circle_avx2(head, weight, a, energy, top, v_Top);
+		// c <= e_u iff max(c, e_u) == e_u
+		__m256i le = _mm256_cmpeq_epi32(_mm256_max_epu32(c, v_e_u), v_e_u);
+		count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(le)));
+	}
+	return count + count_scalar(head + a, weight + a, deg - a, energy, Top, e_u);
+}
+
+/* AVX-512 kernels, 16 arcs per step, the last block is masked */
+
+// (-) on the arcs of @mask starting at @a
+__attribute__((target("avx512f")))
+static inline __m512i circle_avx512(const uint32_t* head, const int32_t* weight, unsigned long a,
+	__mmask16 mask, const uint32_t* energy, __m512i top, __m512i Top){
+	__m512i h = _mm512_maskz_loadu_epi32(mask, head + a);
+	__m512i w = _mm512_maskz_loadu_epi32(mask, weight + a);
+	__m512i e = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, h, energy, 4);
+	__mmask16 neg = _mm512_cmplt_epi32_mask(w, _mm512_setzero_si512());
+	__m512i x = _mm512_sub_epi32(_mm512_max_epu32(e, w), w); // w >= 0
+	x = _mm512_mask_sub_epi32(x, neg, e, w); // e + |w|, w < 0
+	__mmask16 saturate = _mm512_mask_cmplt_epu32_mask(neg, x, e) | // overflow
+		_mm512_cmpgt_epu32_mask(x, Top) | _mm512_cmpeq_epi32_mask(e, top);
+	return _mm512_mask_mov_epi32(x, saturate, top);
+}
+
+__attribute__((target("avx512f")))
+static uint32_t lift_avx512(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, bool max_player){
+	__m512i top = _mm512_set1_epi32(-1);
+	__m512i v_Top = _mm512_set1_epi32(Top);
+	__m512i acc = max_player ? top : _mm512_setzero_si512();
+	for(unsigned long a=0; a < deg; a += 16){
+		__mmask16 mask = deg - a >= 16 ? 0xFFFF : (__mmask16) ((1u << (deg - a)) - 1);
+		__m512i c = circle_avx512(head, weight, a, mask, energy, top, v_Top);
+		acc = max_player ? _mm512_mask_min_epu32(acc, mask, acc, c) : _mm512_mask_max_epu32(acc, mask, acc, c);
+	}
+	return max_player ? _mm512_reduce_min_epu32(acc) : _mm512_reduce_max_epu32(acc);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static unsigned long count_avx512(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, uint32_t e_u){
+	__m512i top = _mm512_set1_epi32(-1);
+	__m512i v_Top = _mm512_set1_epi32(Top);
+	__m512i v_e_u = _mm512_set1_epi32(e_u);
+	unsigned long count = 0;
+	for(unsigned long a=0; a < deg; a += 16){
+		__mmask16 mask = deg - a >= 16 ? 0xFFFF : (__mmask16) ((1u << (deg - a)) - 1);
+		__m512i c = circle_avx512(head, weight, a, mask, energy, top, v_Top);
+		count += __builtin_popcount(_mm512_mask_cmple_epu32_mask(mask, c, v_e_u));
+	}
+	return count;
+}
+
+/* runtime dispatch */
+
+static t_simd simd_isa = SIMD_SCALAR;
+uint32_t (*lift_kernel32)(const uint32_t*, const int32_t*, unsigned long, const uint32_t*, uint32_t, bool) = lift_scalar;
+unsigned long (*count_kernel32)(const uint32_t*, const int32_t*, unsigned long, const uint32_t*, uint32_t, uint32_t) = count_scalar;
+
+t_simd VI_set_simd(t_simd isa){
+	__builtin_cpu_init();
+	bool avx512 = __builtin_cpu_supports("avx512f");
+	bool avx2 = __builtin_cpu_supports("avx2");
+	if(isa == SIMD_AUTO) isa = SIMD_AVX512;
+	if(isa == SIMD_AVX512 && !avx512) isa = SIMD_AVX2;
+	if(isa == SIMD_AVX2 && !avx2) isa = SIMD_SCALAR;
+	switch(isa){
+		case SIMD_AVX512:
+			lift_kernel32 = lift_avx512;
+			count_kernel32 = count_avx512;
+		break;
+		case SIMD_AVX2:
+			lift_kernel32 = lift_avx2;
+			count_kernel32 = count_avx2;
+		break;
+		default:
+			lift_kernel32 = lift_scalar;
+			count_kernel32 = count_scalar;
+	}
+	simd_isa = isa;
+	return isa;
+}
+
+t_simd VI_get_simd(){
+	return simd_isa;
+}
+
+const char* VI_simd_name(t_simd isa){
+	switch(isa){
+		case SIMD_AVX512: return "avx512";
+		case SIMD_AVX2: return "avx2";
+		case SIMD_SCALAR: return "scalar";
+		default: return "auto";
+	}
+}
+
+// picks the widest instruction set at startup
+static t_simd simd_init = VI_set_simd(SIMD_AUTO);
@@ -0,0 +1,52 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Vectorised kernels of the lift and count operators of Value Iteration on the arcs
+*  out of a vertex, for games stored with 32-bit width. The instruction set is picked
+*  at runtime among AVX-512, AVX2 and a scalar fallback, see VIsimd.cc.
+*****************************************************************************************/
+
+#ifndef VI_SIMD
+#define VI_SIMD
+
+#include <stdint.h>
+#include "../mpg/mpg.h"
+
+// vertices with fewer arcs are processed by the inlined scalar loops of VI.cc
+#define SIMD_MIN_DEG 8
+
+enum t_simd{
+	SIMD_AUTO=0, // the widest instruction set supported by the CPU
+	SIMD_SCALAR,
+	SIMD_AVX2,
+	SIMD_AVX512
+};
+
+// selects the kernels of instruction set @isa, or of the widest supported one
+// that is not wider, returns the selected instruction set
+t_simd VI_set_simd(t_simd isa);
+t_simd VI_get_simd();
+const char* VI_simd_name(t_simd isa);
+
+// min (@max_player) or max (!@max_player) of energy[head[i]] (-) weight[i], i < @deg,
+// starting from \top or 0, and saturating above @Top to \top (UINT32_MAX)
+extern uint32_t (*lift_kernel32)(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, bool max_player);
+// number of i < @deg such that energy[head[i]] (-) weight[i] <= @e_u
+extern unsigned long (*count_kernel32)(const uint32_t* head, const int32_t* weight, unsigned long deg,
+	const uint32_t* energy, uint32_t Top, uint32_t e_u);
+
+#endif
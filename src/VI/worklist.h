@@ -0,0 +1,194 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Worklists of the Value Iteration main loop, one class per scheduling policy.
+*  Each vertex is in the worklist at most once, so every worklist is backed by
+*  fixed size arrays taken from the solver workspace, pushing never allocates.
+*  All the classes share the same interface:
+*   push(v, key): inserts vertex v, key is its current energy, v must not be contained;
+*   pop(): removes and returns the next vertex; empty(); contains(v).
+*****************************************************************************************/
+
+#ifndef VI_WORKLIST
+#define VI_WORKLIST
+
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+#include <stdint.h>
+#include "../mpg/mpg.h"
+#include "../workspace/workspace.h"
+
+/* the membership flags shared by all the worklists */
+template<typename I>
+class WorklistBase{
+	protected:
+		bool* in_list;
+	public:
+		WorklistBase(I size, SolverWorkspace* ws){
+			this->in_list = ws->get<bool>(WS_IN_LIST, size);
+			std::fill_n(this->in_list, size, false);
+		}
+		bool contains(I v){ return this->in_list[v]; }
+};
+
+/* LIFO stack */
+template<typename I>
+class LifoWorklist : public WorklistBase<I>{
+	private:
+		I* stack;
+		I len;
+	public:
+		LifoWorklist(I n_0, I size, SolverWorkspace* ws) : WorklistBase<I>(size, ws){
+			this->stack = ws->get<I>(WS_LIST, size);
+			this->len = 0;
+		}
+		bool empty(){ return this->len == 0; }
+		void push(I v, I key){
+			assert(!this->in_list[v]);
+			this->in_list[v] = true;
+			this->stack[this->len++] = v;
+		}
+		I pop(){
+			I v = this->stack[--this->len];
+			this->in_list[v] = false;
+			return v;
+		}
+};
+
+/* FIFO queue on a ring buffer of @capacity slots, in the workspace slot @slot */
+template<typename I>
+class Ring{
+	private:
+		I* buf;
+		I capacity, first, len;
+	public:
+		Ring(I capacity, SolverWorkspace* ws, t_ws_slot slot){
+			this->buf = ws->get<I>(slot, capacity > 0 ? capacity : 1);
+			this->capacity = capacity;
+			this->first = this->len = 0;
+		}
+		bool empty(){ return this->len == 0; }
+		void push(I v){
+			assert(this->len < this->capacity);
+			I last = this->first + this->len;
+			if(last >= this->capacity) last -= this->capacity;
+			this->buf[last] = v;
+			this->len++;
+		}
+		I pop(){
+			I v = this->buf[this->first];
+			if(++this->first == this->capacity) this->first = 0;
+			this->len--;
+			return v;
+		}
+};
+
+/* FIFO queue */
+template<typename I>
+class FifoWorklist : public WorklistBase<I>{
+	private:
+		Ring<I> ring;
+	public:
+		FifoWorklist(I n_0, I size, SolverWorkspace* ws) : WorklistBase<I>(size, ws), ring(size, ws, WS_LIST){}
+		bool empty(){ return this->ring.empty(); }
+		void push(I v, I key){
+			assert(!this->in_list[v]);
+			this->in_list[v] = true;
+			this->ring.push(v);
+		}
+		I pop(){
+			I v = this->ring.pop();
+			this->in_list[v] = false;
+			return v;
+		}
+};
+
+/* two FIFO queues, one per player: the vertices of player @first_player
+   are popped first */
+template<typename I>
+class TwoQueueWorklist : public WorklistBase<I>{
+	private:
+		I n_0;
+		bool first_player;
+		Ring<I> queue_min, queue_max;
+	public:
+		TwoQueueWorklist(I n_0, I size, bool first_player, SolverWorkspace* ws) :
+			WorklistBase<I>(size, ws), queue_min(n_0, ws, WS_LIST), queue_max(size - n_0, ws, WS_LIST2){
+			this->n_0 = n_0;
+			this->first_player = first_player;
+		}
+		bool empty(){ return this->queue_min.empty() && this->queue_max.empty(); }
+		void push(I v, I key){
+			assert(!this->in_list[v]);
+			this->in_list[v] = true;
+			if(v < this->n_0) this->queue_min.push(v);
+			else this->queue_max.push(v);
+		}
+		I pop(){
+			bool from_max = this->first_player == MAX ?
+				!this->queue_max.empty() : this->queue_min.empty();
+			I v = from_max ? this->queue_max.pop() : this->queue_min.pop();
+			this->in_list[v] = false;
+			return v;
+		}
+};
+
+/* bucket queue on the bit length of the energies: the vertices with the
+   smallest energies are popped first, in LIFO order within a bucket.
+   \top gets the last bucket. Buckets are stacks linked through @next */
+template<typename I>
+class PriorityWorklist : public WorklistBase<I>{
+	private:
+		static const int NUM_BUCKETS = 64;
+		I first[NUM_BUCKETS]; // top of each bucket
+		I len[NUM_BUCKETS]; // size of each bucket
+		I* next; // vertex below each vertex in its bucket
+		uint64_t non_empty; // bit b is set iff bucket b is not empty
+		static int bucket(I key){
+			if(key == std::numeric_limits<I>::max()) return NUM_BUCKETS-1;
+			if(key == 0) return 0;
+			int bits = 64 - __builtin_clzll((unsigned long long) key);
+			return std::min(bits, NUM_BUCKETS-2);
+		}
+	public:
+		PriorityWorklist(I n_0, I size, SolverWorkspace* ws) : WorklistBase<I>(size, ws){
+			this->next = ws->get<I>(WS_LIST, size);
+			std::fill_n(this->first, NUM_BUCKETS, 0);
+			std::fill_n(this->len, NUM_BUCKETS, 0);
+			this->non_empty = 0;
+		}
+		bool empty(){ return this->non_empty == 0; }
+		void push(I v, I key){
+			assert(!this->in_list[v]);
+			this->in_list[v] = true;
+			int b = bucket(key);
+			this->next[v] = this->first[b];
+			this->first[b] = v;
+			this->len[b]++;
+			this->non_empty |= (uint64_t) 1 << b;
+		}
+		I pop(){
+			int b = __builtin_ctzll(this->non_empty);
+			I v = this->first[b];
+			this->first[b] = this->next[v];
+			if(--this->len[b] == 0) this->non_empty &= ~((uint64_t) 1 << b);
+			this->in_list[v] = false;
+			return v;
+		}
+};
+
+#endif
@@ -0,0 +1,348 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_TSC 1
+#else
+#define HAS_TSC 0
+#endif
+#include "../conf.h"
+#include "../mpg/mpg.h"
+#include "../VI/VI.h"
+#include "../kasi/kasi_impl.h"
+#include "../gen/gen.h"
+
+using namespace std;
+
+/*****************************************************************************************
+*  Microbenchmarks of the kernels of the solvers on a synthetic game of gen.h. A run of
+*  a kernel is one pass over the arcs it reads, its time is reported per arc, in ns and
+*  in TSC reference cycles, as the best and the median of the runs:
+*   circle_op/vi: circle_op on the out-arcs of every vertex, as read by the lifts of VI;
+*   circle_op/kasi: circle_op on the in-arcs of every vertex, as read by update_Bz of KASI;
+*   lift_op: the lift of every vertex; get_count: the count of every Max vertex;
+*   dijkstra: a full KASI_Dijkstra run on the strategy of Min choosing its first arcs,
+*     from zero energies, per arc of the strategy projection;
+*   update_Bz: the update of Bz after that run, per arc of the strategy projection;
+*   load_dat, load_bin: MeanPayoffGame construction from the ".dat" and ".bin" files, the
+*     ".bin" file is mapped, and its pages are only read on their first use.
+*  The energies read by the VI kernels are random, \top with probability 1/16.
+*****************************************************************************************/
+
+ofstream o_stream;
+
+#define NUM_KERNELS 8
+const char* KERNEL_NAMES[NUM_KERNELS] = {"circle_op/vi", "circle_op/kasi", "lift_op", "get_count", "dijkstra", "update_Bz", "load_dat", "load_bin"};
+
+// options of the benchmark, see usage()
+struct t_bench_conf{
+	t_gen_conf gen;
+	unsigned int reps = 10; // timed runs of each kernel
+	bool kernels[NUM_KERNELS] = {true, true, true, true, true, true, true, true};
+	t_kasi_queue queue = KASI_RADIX;
+	string dir = "/tmp"; // of the files of load_dat and load_bin
+	bool csv = false;
+};
+
+// time of a run
+struct t_time{
+	double ns;
+	unsigned long long cycles;
+};
+
+t_bench_conf CONF;
+volatile unsigned long SINK; // results of the kernels, so that they are not optimised out
+
+void usage(ostream& out);
+void parse_args(int argc, char** argv);
+
+/*****************
+** timing
+*****************/
+struct t_clock{
+	timespec start;
+	unsigned long long tsc;
+};
+
+inline unsigned long long read_tsc(){
+#if HAS_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+inline t_clock clock_start(){
+	t_clock c;
+	clock_gettime(CLOCK_MONOTONIC, &c.start);
+	c.tsc = read_tsc();
+	return c;
+}
+
+inline t_time clock_stop(const t_clock& c){
+	unsigned long long tsc = read_tsc();
+	timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	t_time t;
+	t.ns = (end.tv_sec - c.start.tv_sec) * 1e9 + (end.tv_nsec - c.start.tv_nsec);
+	t.cycles = tsc - c.tsc;
+	return t;
+}
+
+// prints the best and median times per arc of the runs @times of kernel @k
+void report(int k, unsigned long arcs, vector<t_time> times){
+	if(arcs == 0) arcs = 1;
+	vector<double> ns, cycles;
+	for(unsigned long i=0; i < times.size(); i++){
+		ns.push_back(times[i].ns / arcs);
+		cycles.push_back((double) times[i].cycles / arcs);
+	}
+	sort(ns.begin(), ns.end());
+	sort(cycles.begin(), cycles.end());
+	double ns_median = ns[ns.size() / 2], cycles_median = cycles[cycles.size() / 2];
+	if(CONF.csv){
+		cout << KERNEL_NAMES[k] << "," << arcs << "," << ns[0] << "," << ns_median << ",";
+		if(HAS_TSC) cout << cycles[0] << "," << cycles_median;
+		else cout << ",";
+		cout << endl;
+		return;
+	}
+	cout << left << setw(16) << KERNEL_NAMES[k] << right << setw(12) << arcs << fixed << setprecision(3)
+		<< setw(12) << ns[0] << setw(12) << ns_median;
+	if(HAS_TSC) cout << setw(14) << cycles[0] << setw(14) << cycles_median;
+	else cout << setw(14) << "n/a" << setw(14) << "n/a";
+	cout << defaultfloat << endl;
+}
+
+/*****************
+** kernels
+*****************/
+// runs @reset() untimed, then @run(), CONF.reps times, and reports them as kernel @k
+template<typename R, typename F>
+void bench_kernel(int k, unsigned long arcs, R reset, F run){
+	if(!CONF.kernels[k]) return;
+	vector<t_time> times;
+	reset();
+	run(); // warm up the caches
+	for(unsigned int i=0; i < CONF.reps; i++){
+		reset();
+		t_clock c = clock_start();
+		run();
+		times.push_back(clock_stop(c));
+	}
+	report(k, arcs, times);
+}
+
+template<typename I, typename W>
+void bench_kernels(MeanPayoffGame *mpg){
+	const I top = numeric_limits<I>::max();
+	I n_0 = mpg->get_n_0();
+	I size = n_0 + mpg->get_n_1();
+	t_nrg Top = mpg->get_Top();
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
+	unsigned long m = mpg->get_e();
+	unsigned long m_1 = m - csr->offset[n_0]; // arcs of Max
+	// random energies of the VI kernels
+	mt19937_64 rng(CONF.gen.seed);
+	t_nrg range = min(Top, (t_nrg) 4 * max(mpg->get_max_weight(), -mpg->get_min_weight()) + 1);
+	vector<I> initial(size), energy(size);
+	for(I u=0; u < size; u++) initial[u] = rng() % 16 == 0 ? top : (I) (rng() % (range + 1));
+	auto restore = [&](){ copy(initial.begin(), initial.end(), energy.begin()); };
+
+	bench_kernel(0, m, restore, [&](){
+		unsigned long sum = 0;
+		for(I u=0; u < size; u++)
+			for(I a=csr->offset[u]; a < csr->offset[u+1]; a++)
+				sum += circle_op(Top, energy[csr->head[a]], csr->weight[a]);
+		SINK = sum;
+	});
+	bench_kernel(1, m, restore, [&](){
+		unsigned long sum = 0;
+		for(I u=0; u < size; u++)
+			for(I i=rev->offset[u]; i < rev->offset[u+1]; i++)
+				sum += circle_op(Top, energy[u], rev->weight[i]) + rev->tail[i];
+		SINK = sum;
+	});
+	bench_kernel(2, m, restore, [&](){
+		for(I u=0; u < size; u++) lift_op(csr, n_0, Top, energy.data(), u);
+		SINK = energy[size-1];
+	});
+	bench_kernel(3, m_1, restore, [&](){
+		unsigned long sum = 0;
+		for(I u=n_0; u < size; u++) sum += get_count(csr, n_0, Top, energy.data(), u);
+		SINK = sum;
+	});
+	if(CONF.kernels[4] || CONF.kernels[5]){
+		KASI_kernels<I, W> kasi(mpg, CONF.queue);
+		bench_kernel(4, n_0 + m_1, [&](){ kasi.reset(); }, [&](){ kasi.dijkstra(); });
+		bench_kernel(5, n_0 + m_1, [&](){ kasi.reset(); kasi.dijkstra(); }, [&](){ SINK = kasi.update_Bz(); });
+	}
+}
+
+// writes @mpg to temporary files and times its loading from them
+void bench_load(MeanPayoffGame *mpg){
+	if(!CONF.kernels[6] && !CONF.kernels[7]) return;
+	string base = CONF.dir + "/mpg_bench_" + to_string(getpid());
+	string dat = base + ".dat", bin = base + ".bin";
+	unsigned long m = mpg->get_e();
+	if(CONF.kernels[6]){
+		o_stream.open(dat);
+		if(!o_stream.is_open()) throw "cannot open a file of the benchmark directory";
+		mpg->print();
+		o_stream.close();
+		bench_kernel(6, m, [](){}, [&](){ delete new MeanPayoffGame(dat.c_str()); });
+		unlink(dat.c_str());
+	}
+	if(CONF.kernels[7]){
+		mpg->save_bin(bin.c_str());
+		bench_kernel(7, m, [](){}, [&](){ delete new MeanPayoffGame(bin.c_str()); });
+		unlink(bin.c_str());
+	}
+}
+
+/********************************************
+** microbenchmarks main()
+*******************************************/
+int main(int argc, char** argv){
+	try{
+		parse_args(argc, argv);
+		MeanPayoffGame* mpg = generate_game(CONF.gen);
+		mpg->share();
+		if(CONF.csv) cout << "kernel,arcs,best_ns_per_arc,median_ns_per_arc,best_cycles_per_arc,median_cycles_per_arc" << endl;
+		else{
+			cout << gen_family_name(CONF.gen.family) << " game, " << mpg->get_width() << "-bit, n_0=" << mpg->get_n_0()
+				<< " n_1=" << mpg->get_n_1() << " m=" << mpg->get_e() << " weights [" << mpg->get_min_weight() << ", "
+				<< mpg->get_max_weight() << "], seed " << CONF.gen.seed << ", " << CONF.reps << " runs" << endl;
+			cout << left << setw(16) << "kernel" << right << setw(12) << "arcs" << setw(12) << "ns/arc" << setw(12) << "median"
+				<< setw(14) << "cycles/arc" << setw(14) << "median" << endl;
+		}
+		if(mpg->get_width() == WIDTH_32) bench_kernels<uint32_t, int32_t>(mpg);
+		else bench_kernels<t_idx, t_weight>(mpg);
+		bench_load(mpg);
+		delete mpg;
+	}catch(const char* msg){
+		cerr << "Error: " << msg << endl;
+		return -1;
+	}
+	return 0;
+}
+
+/*****************
+** options
+*****************/
+void usage(ostream& out){
+	out << "bench usage is: bench [options]" << endl
+		<< "  -f, --family random|ladder|clique|clustered|chain  synthetic game, see gen.h (default random)" << endl
+		<< "  -n, --vertices N       vertices, half of them Min's (default 1000000)" << endl
+		<< "  -d, --min-deg N        min out-degree (default 1)" << endl
+		<< "  -D, --max-deg N        max out-degree (default 10)" << endl
+		<< "  -w, --max-weight N     weights in [-N, N] (default 100)" << endl
+		<< "  -s, --seed N           seed of the game and of the energies (default 0)" << endl
+		<< "      --width 32|64      storage width (default the narrowest)" << endl
+		<< "  -r, --reps N           timed runs of each kernel (default 10)" << endl
+		<< "  -k, --kernels LIST     kernels to run, comma separated (default all):" << endl
+		<< "                         ";
+	for(int k=0; k < NUM_KERNELS; k++) out << (k ? "," : "") << KERNEL_NAMES[k];
+	out << endl
+		<< "      --queue radix|dary KASI priority queue (default radix)" << endl
+		<< "      --dir DIR          directory of the files of the load kernels (default /tmp)" << endl
+		<< "      --csv              CSV output" << endl;
+}
+
+unsigned long parse_count(const char* arg){
+	char* end;
+	unsigned long x = strtoul(arg, &end, 10);
+	if(*arg == '\0' || *end != '\0' || *arg == '-') throw "invalid number";
+	return x;
+}
+
+void parse_args(int argc, char** argv){
+	enum{OPT_WIDTH=256, OPT_QUEUE, OPT_DIR, OPT_CSV};
+	static const struct option options[] = {
+		{"family", required_argument, NULL, 'f'},
+		{"vertices", required_argument, NULL, 'n'},
+		{"min-deg", required_argument, NULL, 'd'},
+		{"max-deg", required_argument, NULL, 'D'},
+		{"max-weight", required_argument, NULL, 'w'},
+		{"seed", required_argument, NULL, 's'},
+		{"width", required_argument, NULL, OPT_WIDTH},
+		{"reps", required_argument, NULL, 'r'},
+		{"kernels", required_argument, NULL, 'k'},
+		{"queue", required_argument, NULL, OPT_QUEUE},
+		{"dir", required_argument, NULL, OPT_DIR},
+		{"csv", no_argument, NULL, OPT_CSV},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	CONF.gen.n_0 = CONF.gen.n_1 = 500000;
+	int opt;
+	while((opt = getopt_long(argc, argv, "f:n:d:D:w:s:r:k:h", options, NULL)) != -1){
+		switch(opt){
+			case 'f': CONF.gen.family = gen_family_from_string(optarg); break;
+			case 'n':{
+				unsigned long n = parse_count(optarg);
+				CONF.gen.n_0 = n - n / 2;
+				CONF.gen.n_1 = n / 2;
+			}break;
+			case 'd': CONF.gen.min_deg = parse_count(optarg); break;
+			case 'D': CONF.gen.max_deg = parse_count(optarg); break;
+			case 'w': CONF.gen.max_weight = parse_count(optarg); break;
+			case 's': CONF.gen.seed = parse_count(optarg); break;
+			case OPT_WIDTH:
+				CONF.gen.width = (t_width) parse_count(optarg);
+				if(CONF.gen.width != WIDTH_32 && CONF.gen.width != WIDTH_64) throw "invalid width";
+				break;
+			case 'r': CONF.reps = parse_count(optarg); break;
+			case 'k':{
+				fill_n(CONF.kernels, NUM_KERNELS, false);
+				stringstream list(optarg);
+				string name;
+				while(getline(list, name, ',')){
+					int k = find(KERNEL_NAMES, KERNEL_NAMES + NUM_KERNELS, name) - KERNEL_NAMES;
+					if(k == NUM_KERNELS) throw "unknown kernel";
+					CONF.kernels[k] = true;
+				}
+			}break;
+			case OPT_QUEUE: CONF.queue = KASI_queue_from_string(optarg); break;
+			case OPT_DIR: CONF.dir = optarg; break;
+			case OPT_CSV: CONF.csv = true; break;
+			case 'h':
+				usage(cout);
+				exit(0);
+			default:
+				usage(cerr);
+				throw "invalid arguments";
+		}
+	}
+	if(optind != argc){
+		usage(cerr);
+		throw "invalid arguments";
+	}
+	if(CONF.reps == 0) throw "at least one timed run is needed";
+}
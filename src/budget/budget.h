@@ -0,0 +1,78 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Time budget and cancellation of the solvers: the hot loops poll a SolveBudget, which
+*  reads the cancel flag and the clock once every few calls. A solve stopped early
+*  returns its current energies, which lie below the least fixpoint for VI and KASI.
+*****************************************************************************************/
+
+#ifndef BUDGET
+#define BUDGET
+
+#include <chrono>
+
+typedef std::chrono::steady_clock::time_point t_deadline;
+#define NO_DEADLINE t_deadline::max()
+
+// outcome of a solve
+enum t_status{
+	SOLVE_CONVERGED=0, // the energies are the least fixpoint
+	SOLVE_CANCELLED, // stopped by the cancel flag, the energies are below the least fixpoint
+	SOLVE_TIMEOUT, // stopped at the deadline, the energies are below the least fixpoint
+	SOLVE_NUM_STATUSES
+};
+
+// returns the deadline @seconds from now
+inline t_deadline deadline_in(double seconds){
+	return std::chrono::steady_clock::now() + 
+		std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+inline const char* status_name(t_status status){
+	static const char* names[SOLVE_NUM_STATUSES] = {"converged", "cancelled", "timeout"};
+	return names[status];
+}
+
+/* the budget of a solve, for a single thread: expired() is true from the first call
+   that finds *@cancel set or the deadline past, which are checked every @period calls */
+class SolveBudget{
+	public:
+	SolveBudget(const bool* cancel, t_deadline deadline, unsigned long period){
+		this->cancel = cancel;
+		this->deadline = deadline;
+		this->period = this->calls = (cancel != NULL || deadline != NO_DEADLINE) ? period : 0;
+		this->status = SOLVE_CONVERGED;
+	}
+	bool expired(){
+		if(this->calls == 0) return this->status != SOLVE_CONVERGED; // no budget, or stopped
+		if(--this->calls > 0) return false;
+		this->calls = this->period;
+		if(this->cancel != NULL && __atomic_load_n(this->cancel, __ATOMIC_RELAXED)) this->status = SOLVE_CANCELLED;
+		else if(this->deadline != NO_DEADLINE && std::chrono::steady_clock::now() >= this->deadline) this->status = SOLVE_TIMEOUT;
+		if(this->status != SOLVE_CONVERGED) this->calls = 0;
+		return this->status != SOLVE_CONVERGED;
+	}
+	// SOLVE_CONVERGED until expired() returned true
+	t_status get_status(){ return this->status; }
+
+	private:
+	const bool* cancel;
+	t_deadline deadline;
+	unsigned long period, calls; // calls left before the next check, 0 if none
+	t_status status;
+};
+
+#endif
@@ -0,0 +1,153 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include <climits>
+#include <assert.h>
+#include "cert.h"
+
+using namespace std;
+
+static const char* CERT_NAMES[] = {"invalid", "fixpoint", "strategy"};
+
+// stores @v in @witness, returns CERT_INVALID
+static t_cert invalid(t_idx* witness, t_idx v){
+	if(witness != NULL) *witness = v;
+	return CERT_INVALID;
+}
+
+template<typename I, typename W>
+static t_cert certify(MeanPayoffGame *mpg, const t_nrg* energy, const t_idx* strategy, t_idx* witness){
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	t_nrg Top = mpg->get_Top();
+	t_idx n_0 = mpg->get_n_0();
+	t_idx size = n_0 + mpg->get_n_1();
+	// fixpoint equations: e(v) = max (Min) or min (Max) of e(u) (-) w
+	for(t_idx v=0; v < size; v++){
+		if(energy[v] != ULONG_MAX && energy[v] > Top) return invalid(witness, v);
+		t_nrg lifted = v < n_0 ? 0 : ULONG_MAX;
+		for(I a=csr->offset[v]; a < csr->offset[v+1]; a++){
+			t_nrg c = circle_op(Top, energy[csr->head[a]], (t_weight) csr->weight[a]);
+			if((v < n_0 && c > lifted) || (v >= n_0 && c < lifted)) lifted = c;
+		}
+		if(lifted != energy[v]) return invalid(witness, v);
+	}
+	if(strategy == NULL) return CERT_FIXPOINT;
+	// Min's arcs are tight
+	for(t_idx v=0; v < n_0; v++){
+		t_idx a = strategy[v];
+		if(a < csr->offset[v] || a >= csr->offset[v+1] ||
+			circle_op(Top, energy[csr->head[a]], (t_weight) csr->weight[a]) != energy[v])
+			return invalid(witness, v);
+	}
+	// the tight arcs (v,u), e(v) = e(u) - w > 0 and e(u) > 0 finite, with Min's
+	// arcs restricted to @strategy, are acyclic: Kahn's algorithm on their heads
+	auto positive = [&](t_idx v){ return energy[v] > 0 && energy[v] != ULONG_MAX; };
+	auto tight = [&](t_idx v, I a){
+		t_idx u = csr->head[a];
+		return positive(u) && (int64_t) energy[u] - (int64_t) csr->weight[a] == (int64_t) energy[v];
+	};
+	vector<t_idx> out_tight(size, 0); // tight arcs out of each positive vertex not yet removed
+	vector<t_idx> sinks;
+	for(t_idx v=0; v < size; v++){
+		if(!positive(v)) continue;
+		I first = v < n_0 ? strategy[v] : csr->offset[v];
+		I last = v < n_0 ? first + 1 : csr->offset[v+1];
+		for(I a=first; a < last; a++) if(tight(v, a)) out_tight[v]++;
+		if(out_tight[v] == 0) sinks.push_back(v);
+	}
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
+	while(!sinks.empty()){
+		t_idx u = sinks.back();
+		sinks.pop_back();
+		for(I i=rev->offset[u]; i < rev->offset[u+1]; i++){
+			t_idx v = rev->tail[i];
+			if(!positive(v) || (v < n_0 && strategy[v] != rev->arc[i]) || !tight(v, rev->arc[i])) continue;
+			if(--out_tight[v] == 0) sinks.push_back(v);
+		}
+	}
+	for(t_idx v=0; v < size; v++)
+		if(positive(v) && out_tight[v] > 0) return invalid(witness, v); // on or leading to a tight cycle
+	return CERT_STRATEGY;
+}
+
+t_cert certify_energy(MeanPayoffGame *mpg, const t_nrg* energy, const t_idx* strategy, t_idx* witness){
+	if(mpg->get_width() == WIDTH_32) return certify<uint32_t, int32_t>(mpg, energy, strategy, witness);
+	return certify<t_idx, t_weight>(mpg, energy, strategy, witness);
+}
+
+const char* cert_name(t_cert cert){
+	assert(cert <= CERT_STRATEGY);
+	return CERT_NAMES[cert];
+}
+
+template<typename I, typename W>
+static void min_strategy(MeanPayoffGame *mpg, const t_nrg* energy, t_idx* strategy){
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
+	t_nrg Top = mpg->get_Top();
+	t_idx n_0 = mpg->get_n_0();
+	t_idx size = n_0 + mpg->get_n_1();
+	auto positive = [&](t_idx v){ return energy[v] > 0 && energy[v] != ULONG_MAX; };
+	auto tight = [&](t_idx v, I a){
+		t_idx u = csr->head[a];
+		return positive(u) && (int64_t) energy[u] - (int64_t) csr->weight[a] == (int64_t) energy[v];
+	};
+	// pending[v]: tight arcs out of the positive vertex v that must lead to resolved vertices,
+	// all of them for Max, one for Min, none if Min reaches its lift by an arc into a vertex
+	// that is not positive
+	vector<t_idx> pending(size, 0);
+	vector<t_idx> resolved;
+	for(t_idx v=0; v < size; v++){
+		bool sink = true;
+		if(v < n_0) strategy[v] = csr->offset[v];
+		for(I a=csr->offset[v]; a < csr->offset[v+1]; a++){
+			if(v < n_0 && circle_op(Top, energy[csr->head[a]], (t_weight) csr->weight[a]) == energy[v]){
+				if(!positive(v) || !tight(v, a)){
+					strategy[v] = a;
+					sink = true;
+					break;
+				}
+				if(sink) strategy[v] = a; // replaced once a tight arc reaches a resolved vertex
+				sink = false;
+			}
+			if(v >= n_0 && positive(v) && tight(v, a)){
+				pending[v]++;
+				sink = false;
+			}
+		}
+		if(!positive(v)) continue;
+		if(v < n_0 && !sink) pending[v] = 1;
+		if(pending[v] == 0) resolved.push_back(v);
+	}
+	while(!resolved.empty()){
+		t_idx u = resolved.back();
+		resolved.pop_back();
+		for(I i=rev->offset[u]; i < rev->offset[u+1]; i++){
+			t_idx v = rev->tail[i];
+			if(!positive(v) || pending[v] == 0 || !tight(v, rev->arc[i])) continue;
+			if(v < n_0){
+				strategy[v] = rev->arc[i];
+				pending[v] = 0;
+			}else pending[v]--;
+			if(pending[v] == 0) resolved.push_back(v);
+		}
+	}
+}
+
+void cert_min_strategy(MeanPayoffGame *mpg, const t_nrg* energy, t_idx* strategy){
+	if(mpg->get_width() == WIDTH_32) min_strategy<uint32_t, int32_t>(mpg, energy, strategy);
+	else min_strategy<t_idx, t_weight>(mpg, energy, strategy);
+}
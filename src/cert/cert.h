@@ -0,0 +1,49 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  O(m) checker of the energies computed by the solvers, an alternative to comparing
+*  the results of two solvers. A fixpoint of the lift operator of [Brim2011] is above
+*  the least fixpoint, so the check of the fixpoint equations bounds the energies from
+*  above. A positional strategy of Min bounds them from below: in the game where Min
+*  plays it, its arcs must be tight and the tight arcs between vertices of positive
+*  finite energy must be acyclic, so that Max loses every play started below the
+*  energies of the finite vertices. The \top vertices are only checked to be part of
+*  the fixpoint: a \top vertex of finite least energy is not detected in linear time.
+*****************************************************************************************/
+
+#ifndef CERT
+#define CERT
+
+#include "../mpg/mpg.h"
+
+enum t_cert{
+	CERT_INVALID=0, // not a fixpoint, or the strategy does not certify the energies
+	CERT_FIXPOINT, // a fixpoint, above the least one
+	CERT_STRATEGY, // a fixpoint, least among the fixpoints with the same \top vertices
+};
+
+// checks the energies @energy of @mpg, ULONG_MAX standing for \top. @strategy, if not NULL,
+// holds the arc index chosen by each Min vertex. The first vertex violating the
+// certificate is stored in @witness, if not NULL
+t_cert certify_energy(MeanPayoffGame *mpg, const t_nrg* energy, const t_idx* strategy, t_idx* witness = NULL);
+const char* cert_name(t_cert cert);
+// stores in @strategy a positional strategy of Min certifying the fixpoint @energy, for the
+// solvers that compute none: every Min vertex chooses an arc reaching its lift, and the
+// positive ones an arc towards the vertices already resolved, backwards from the tight sinks.
+// If @energy is the least fixpoint, certify_energy() of it returns CERT_STRATEGY
+void cert_min_strategy(MeanPayoffGame *mpg, const t_nrg* energy, t_idx* strategy);
+
+#endif
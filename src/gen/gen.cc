@@ -0,0 +1,237 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include <thread>
+#include <string>
+#include <algorithm>
+#include <assert.h>
+#include "gen.h"
+
+using namespace std;
+
+static const char* GEN_FAMILY_NAMES[GEN_NUM_FAMILIES] = {"random", "ladder", "clique", "clustered", "chain"};
+
+/* splitmix64 stream of the arcs of a vertex */
+struct t_gen_rng{
+	uint64_t state;
+
+	t_gen_rng(uint64_t seed, uint64_t u){
+		this->state = seed;
+		this->state = next() ^ u;
+		next();
+	}
+	uint64_t next(){
+		uint64_t x = (this->state += 0x9E3779B97F4A7C15ULL);
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+	// uniform in [0, k), k > 0
+	uint64_t below(uint64_t k){
+		return (uint64_t) (((unsigned __int128) next() * k) >> 64);
+	}
+	// uniform in [0, 1)
+	double uniform(){
+		return (next() >> 11) * 0x1.0p-53;
+	}
+};
+
+// weight uniform in [-@max_weight, @max_weight]
+static inline t_weight gen_weight(t_gen_rng& rng, t_weight max_weight){
+	return (t_weight) rng.below(2 * (uint64_t) max_weight + 1) - max_weight;
+}
+
+// weight of the arcs of GEN_CHAIN
+static inline t_weight chain_weight(const t_gen_conf& conf){
+	return (t_weight) 1 << conf.bits;
+}
+
+// draws the out-degree of a vertex of GEN_RANDOM or GEN_CLUSTERED, first in its stream
+static inline unsigned long draw_deg(const t_gen_conf& conf, t_gen_rng& rng){
+	return conf.min_deg + rng.below(conf.max_deg - conf.min_deg + 1);
+}
+
+// number of arcs out of @u
+static unsigned long gen_deg(const t_gen_conf& conf, unsigned long u){
+	unsigned long size = conf.n_0 + conf.n_1;
+	switch(conf.family){
+		case GEN_RANDOM:
+		case GEN_CLUSTERED:{
+			t_gen_rng rng(conf.seed, u);
+			return draw_deg(conf, rng);
+		}
+		case GEN_LADDER: return 3;
+		case GEN_CLIQUE: return size > 1 ? size - 1 : 1;
+		case GEN_CHAIN: return u < conf.n_0 || u == size - 1 ? 1 : 2;
+		default: throw "unknown game family";
+	}
+}
+
+/* calls @emit(head, weight) on the gen_deg(conf, u) arcs out of @u */
+template<typename F>
+static void gen_vertex(const t_gen_conf& conf, unsigned long u, F emit){
+	unsigned long size = conf.n_0 + conf.n_1;
+	t_gen_rng rng(conf.seed, u);
+	// a head uniform among the vertices other than @u, @u itself if alone
+	auto other = [&](){
+		if(size == 1) return u;
+		unsigned long v = rng.below(size - 1);
+		return v >= u ? v + 1 : v;
+	};
+	switch(conf.family){
+		case GEN_RANDOM:{
+			unsigned long deg = draw_deg(conf, rng);
+			for(unsigned long i=0; i < deg; i++) emit(other(), gen_weight(rng, conf.max_weight));
+		}break;
+		case GEN_LADDER:{ // rung r holds r and n_0 + r
+			unsigned long r = u < conf.n_0 ? u : u - conf.n_0;
+			unsigned long next = (r + 1) % conf.n_0;
+			emit(u < conf.n_0 ? conf.n_0 + r : r, gen_weight(rng, conf.max_weight));
+			emit(next, gen_weight(rng, conf.max_weight));
+			emit(conf.n_0 + next, gen_weight(rng, conf.max_weight));
+		}break;
+		case GEN_CLIQUE:
+			if(size == 1) emit(u, gen_weight(rng, conf.max_weight));
+			for(unsigned long v=0; v < size; v++)
+				if(v != u) emit(v, gen_weight(rng, conf.max_weight));
+			break;
+		case GEN_CLUSTERED:{ // the vertices c, c + clusters, c + 2*clusters... of cluster c
+			unsigned long deg = draw_deg(conf, rng);
+			unsigned long c = u % conf.clusters;
+			unsigned long members = (size - 1 - c) / conf.clusters + 1;
+			for(unsigned long i=0; i < deg; i++){
+				if(members == 1 || rng.uniform() < conf.inter) emit(other(), gen_weight(rng, conf.max_weight));
+				else{
+					unsigned long k = rng.below(members - 1);
+					if(k >= u / conf.clusters) k++;
+					emit(c + k * conf.clusters, gen_weight(rng, conf.max_weight));
+				}
+			}
+		}break;
+		case GEN_CHAIN:{ // gadget i: Min vertex i and Max vertex n_0 + i, the last one has a positive cycle
+			unsigned long i = u < conf.n_0 ? u : u - conf.n_0;
+			t_gen_rng gadget(conf.seed, i);
+			bool positive = i == conf.n_0 - 1 || gadget.next() % 2;
+			t_weight w = chain_weight(conf);
+			if(u < conf.n_0) emit(conf.n_0 + i, -w);
+			else{
+				// a cycle of weight -1 is left once the energy of the next gadget is reached,
+				// raising the energies by 1 on each turn around it
+				emit(i, positive ? w + 1 : w - 1);
+				if(i < conf.n_0 - 1) emit(i + 1, 0);
+			}
+		}break;
+		default: throw "unknown game family";
+	}
+}
+
+/* calls @f(t, first, last) on the range [first, last) of [0, @size) of each thread t < @threads */
+template<typename F>
+static void gen_parallel(unsigned int threads, unsigned long size, F f){
+	auto bound = [&](unsigned int t){ return (unsigned long) ((unsigned __int128) size * t / threads); };
+	vector<thread> workers;
+	for(unsigned int t=1; t < threads; t++) workers.push_back(thread(f, t, bound(t), bound(t+1)));
+	f(0, 0, bound(1));
+	for(unsigned int t=0; t < workers.size(); t++) workers[t].join();
+}
+
+/* fills a CSR arc storage of width (I,W) with the @m arcs of the game of @conf */
+template<typename I, typename W>
+static MeanPayoffGame* gen_csr(const t_gen_conf& conf, unsigned long m, unsigned int threads){
+	unsigned long size = conf.n_0 + conf.n_1;
+	t_csr<I, W> csr;
+	csr.n = size;
+	csr.m = m;
+	csr.offset = new I[size+1];
+	csr.head = new I[m];
+	csr.weight = new W[m];
+	csr.offset[0] = 0;
+	gen_parallel(threads, size, [&](unsigned int t, unsigned long first, unsigned long last){
+		for(unsigned long u=first; u < last; u++) csr.offset[u+1] = gen_deg(conf, u);
+	});
+	for(unsigned long u=0; u < size; u++) csr.offset[u+1] += csr.offset[u];
+	assert(csr.offset[size] == m);
+	gen_parallel(threads, size, [&](unsigned int t, unsigned long first, unsigned long last){
+		for(unsigned long u=first; u < last; u++){
+			I a = csr.offset[u];
+			gen_vertex(conf, u, [&](unsigned long head, t_weight weight){
+				csr.head[a] = head;
+				csr.weight[a] = weight;
+				a++;
+			});
+			assert(a == csr.offset[u+1]);
+		}
+	});
+	try{
+		return new MeanPayoffGame(conf.n_0, conf.n_1, csr);
+	}catch(const char* msg){
+		delete [] csr.offset;
+		delete [] csr.head;
+		delete [] csr.weight;
+		throw;
+	}
+}
+
+MeanPayoffGame* generate_game(const t_gen_conf& conf){
+	unsigned long size = conf.n_0 + conf.n_1;
+	if(size == 0) throw "the game must have a vertex";
+	if(conf.family >= GEN_NUM_FAMILIES) throw "unknown game family";
+	if((conf.family == GEN_LADDER || conf.family == GEN_CHAIN) && conf.n_0 != conf.n_1)
+		throw "the ladder and chain families need as many Min as Max vertices";
+	if(conf.min_deg == 0 || conf.min_deg > conf.max_deg) throw "invalid degree bounds";
+	if(conf.max_weight < 0 || conf.max_weight > LONG_MAX / 2) throw "invalid max weight";
+	if(conf.clusters == 0 || !(conf.inter >= 0 && conf.inter <= 1)) throw "invalid clusters";
+	if(conf.bits > 61) throw "too many weight bits";
+	unsigned int threads = conf.threads > 0 ? conf.threads : thread::hardware_concurrency();
+	if(threads == 0) threads = 1;
+	threads = min((unsigned long) threads, size);
+	// number of arcs and bound on the weights
+	unsigned long m = 0;
+	t_weight max_weight = conf.family == GEN_CHAIN ? chain_weight(conf) + 1 : conf.max_weight;
+	if(conf.family == GEN_RANDOM || conf.family == GEN_CLUSTERED){
+		vector<unsigned long> sum(threads, 0);
+		gen_parallel(threads, size, [&](unsigned int t, unsigned long first, unsigned long last){
+			unsigned long s = 0;
+			for(unsigned long u=first; u < last; u++) s += gen_deg(conf, u);
+			sum[t] = s;
+		});
+		for(unsigned int t=0; t < threads; t++)
+			if(__builtin_add_overflow(m, sum[t], &m)) throw "too many arcs";
+	}else if(conf.family == GEN_CLIQUE){
+		if(size > 1 && __builtin_mul_overflow(size, size - 1, &m)) throw "too many arcs";
+		if(size == 1) m = 1;
+	}else if(conf.family == GEN_LADDER) m = 3 * size;
+	else m = size + conf.n_1 - 1;
+	// the width is chosen on the bound n*max_weight of Top
+	t_width width = conf.width;
+	if(width == WIDTH_AUTO) width = mpg_select_width(size, m, -max_weight, max_weight, mpg_top_bound(size, max_weight));
+	// a forced 32-bit width must still hold the indices and weights
+	if(width == WIDTH_32 && (size >= UINT32_MAX || m >= UINT32_MAX || max_weight > INT32_MAX))
+		throw "the game does not fit in 32-bit width";
+	if(width == WIDTH_32) return gen_csr<uint32_t, int32_t>(conf, m, threads);
+	return gen_csr<t_idx, t_weight>(conf, m, threads);
+}
+
+t_gen_family gen_family_from_string(const char* name){
+	for(int f=0; f < GEN_NUM_FAMILIES; f++)
+		if(string(name) == GEN_FAMILY_NAMES[f]) return (t_gen_family) f;
+	throw "unknown game family";
+}
+
+const char* gen_family_name(t_gen_family family){
+	assert(family < GEN_NUM_FAMILIES);
+	return GEN_FAMILY_NAMES[family];
+}
@@ -0,0 +1,58 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Generators of parameterised families of MPGs, built straight into the CSR arc storage.
+*  The arcs of every vertex are drawn from a random stream seeded by the seed of the
+*  options and the vertex alone, so that a game only depends on its options, and not on
+*  the number of threads filling the ranges of vertices.
+*****************************************************************************************/
+
+#ifndef GEN
+#define GEN
+
+#include "../mpg/mpg.h"
+
+enum t_gen_family{
+	GEN_RANDOM=0, // out-degrees uniform in [min_deg, max_deg], heads uniform among the other vertices
+	GEN_LADDER, // rungs of a Min and a Max vertex, each one reaching its rung mate and the next rung
+	GEN_CLIQUE, // every vertex reaches every other vertex
+	GEN_CLUSTERED, // as GEN_RANDOM, the heads are in the cluster of the tail but for a fraction inter
+	GEN_CHAIN, // 2-cycles of weights about +-2^bits linked in a chain, VI lifts each one 2^bits times
+	GEN_NUM_FAMILIES
+};
+
+// options of generate_game
+struct t_gen_conf{
+	t_gen_family family = GEN_RANDOM;
+	unsigned long n_0 = 500, n_1 = 500; // vertices of Min and Max, equal for GEN_LADDER and GEN_CHAIN
+	unsigned long min_deg = 1, max_deg = 10; // out-degrees of GEN_RANDOM and GEN_CLUSTERED
+	t_weight max_weight = 100; // weights uniform in [-max_weight, max_weight], but for GEN_CHAIN
+	unsigned long clusters = 16; // of GEN_CLUSTERED, vertex u is in cluster u % clusters
+	double inter = 0.05; // fraction of the arcs of GEN_CLUSTERED leaving their cluster
+	unsigned int bits = 16; // of the weights of GEN_CHAIN
+	unsigned long seed = 0;
+	unsigned int threads = 1; // threads filling the arcs, 0 uses all the cores
+	t_width width = WIDTH_AUTO; // of the game, WIDTH_AUTO picks the narrowest that fits the weight bounds
+};
+
+// returns the family named @name ("random", "ladder", "clique", "clustered", "chain")
+t_gen_family gen_family_from_string(const char* name);
+const char* gen_family_name(t_gen_family family);
+
+// returns a new frozen game of the family and size of @conf, to be deleted by the caller
+MeanPayoffGame* generate_game(const t_gen_conf& conf);
+
+#endif
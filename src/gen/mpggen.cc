@@ -0,0 +1,148 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "../conf.h"
+#include "gen.h"
+
+using namespace std;
+
+/*****************************************************************************************
+*  This program generates a Mean Payoff Game of one of the families of gen.h, without
+*  pgsolver. The output is in the ".dat" text format, or in the binary MPG file format
+*  (see t_mpg_bin_header in mpg.h) if the output file name ends with ".bin".
+*****************************************************************************************/
+
+ofstream o_stream;
+
+void usage(ostream& out);
+unsigned long parse_count(const char* arg);
+
+int main(int argc, char** argv){
+	enum{OPT_N0=256, OPT_N1, OPT_WIDTH};
+	static const struct option options[] = {
+		{"family", required_argument, NULL, 'f'},
+		{"vertices", required_argument, NULL, 'n'},
+		{"n0", required_argument, NULL, OPT_N0},
+		{"n1", required_argument, NULL, OPT_N1},
+		{"min-deg", required_argument, NULL, 'd'},
+		{"max-deg", required_argument, NULL, 'D'},
+		{"max-weight", required_argument, NULL, 'w'},
+		{"clusters", required_argument, NULL, 'c'},
+		{"inter", required_argument, NULL, 'i'},
+		{"bits", required_argument, NULL, 'b'},
+		{"seed", required_argument, NULL, 's'},
+		{"threads", required_argument, NULL, 'j'},
+		{"width", required_argument, NULL, OPT_WIDTH},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	t_gen_conf conf;
+	try{
+		int opt;
+		while((opt = getopt_long(argc, argv, "f:n:d:D:w:c:i:b:s:j:h", options, NULL)) != -1){
+			switch(opt){
+				case 'f': conf.family = gen_family_from_string(optarg); break;
+				case 'n':{
+					unsigned long n = parse_count(optarg);
+					conf.n_0 = n - n / 2;
+					conf.n_1 = n / 2;
+				}break;
+				case OPT_N0: conf.n_0 = parse_count(optarg); break;
+				case OPT_N1: conf.n_1 = parse_count(optarg); break;
+				case 'd': conf.min_deg = parse_count(optarg); break;
+				case 'D': conf.max_deg = parse_count(optarg); break;
+				case 'w': conf.max_weight = parse_count(optarg); break;
+				case 'c': conf.clusters = parse_count(optarg); break;
+				case 'i':{
+					char* end;
+					conf.inter = strtod(optarg, &end);
+					if(*end != '\0') throw "invalid fraction";
+				}break;
+				case 'b': conf.bits = parse_count(optarg); break;
+				case 's': conf.seed = parse_count(optarg); break;
+				case 'j': conf.threads = parse_count(optarg); break;
+				case OPT_WIDTH:
+					conf.width = (t_width) parse_count(optarg);
+					if(conf.width != WIDTH_32 && conf.width != WIDTH_64) throw "invalid width";
+					break;
+				case 'h':
+					usage(cout);
+					return 0;
+				default:
+					usage(cout);
+					return -1;
+			}
+		}
+		if(optind != argc - 1){
+			usage(cout);
+			return -1;
+		}
+		const char* output_file = argv[optind];
+		unsigned long out_len = strlen(output_file);
+		bool binary = out_len >= 4 && strcmp(output_file + out_len - 4, ".bin") == 0;
+		MeanPayoffGame* mpg = generate_game(conf);
+		try{
+			if(binary) mpg->save_bin(output_file);
+			else{
+				o_stream.open(output_file);
+				if(!o_stream.is_open()) throw "cannot open output file";
+				mpg->print();
+				o_stream.close();
+				if(o_stream.fail()) throw "cannot write output file";
+			}
+		}catch(const char* msg){
+			delete mpg;
+			throw;
+		}
+		cout << "Generation completed (" << gen_family_name(conf.family) << ", " << mpg->get_width() << "-bit, "
+			<< mpg->get_n_0() + mpg->get_n_1() << " vertices, " << mpg->get_e() << " arcs). See output file " << output_file << endl;
+		delete mpg;
+	}catch(const char* msg){
+		cout << "Error: " << msg << endl;
+		return -1;
+	}
+	return 0;
+}
+
+/* returns @arg as a non negative integer */
+unsigned long parse_count(const char* arg){
+	char* end;
+	unsigned long x = strtoul(arg, &end, 10);
+	if(*arg == '\0' || *end != '\0' || *arg == '-') throw "invalid number";
+	return x;
+}
+
+void usage(ostream& out){
+	out << "mpggen usage is: mpggen [options] <output file>" << endl
+		<< "the output is written in binary MPG format if the output file ends with \".bin\"" << endl
+		<< "  -f, --family random|ladder|clique|clustered|chain  (default random)" << endl
+		<< "  -n, --vertices N       N/2 Max vertices and the others Min's (default 1000)" << endl
+		<< "      --n0 N, --n1 N     Min and Max vertices" << endl
+		<< "  -d, --min-deg N        min out-degree of random and clustered (default 1)" << endl
+		<< "  -D, --max-deg N        max out-degree of random and clustered (default 10)" << endl
+		<< "  -w, --max-weight N     weights in [-N, N], but for chain (default 100)" << endl
+		<< "  -c, --clusters N       clusters of clustered (default 16)" << endl
+		<< "  -i, --inter X          fraction of the arcs of clustered between clusters (default 0.05)" << endl
+		<< "  -b, --bits N           chain weights about 2^N (default 16)" << endl
+		<< "  -s, --seed N           the game only depends on the options and the seed (default 0)" << endl
+		<< "  -j, --threads N        threads, 0 for all cores (default 1)" << endl
+		<< "      --width 32|64      storage width (default the narrowest fitting the weight bounds)" << endl;
+}
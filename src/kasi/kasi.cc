@@ -18,170 +18,649 @@
 #include <sstream>
 #include <assert.h>
 #include <algorithm>
-#include <queue>
 #include <vector>    
-#include <functional> 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "string.h"
 #include "stdlib.h"
 #include "math.h"
 #include "../conf.h"
 #include "../mpg/mpg.h"
-#include "../kasi/kasi.h"
+#include "../kasi/kasi_impl.h"
+#include "pqueue.h"
 
 using namespace std;
 
-typedef unsigned long t_key;
-
-class rev_paircomparison{
-	public:
-  	bool operator() (const pair<t_idx, t_key>& lhs, const pair<t_idx, t_key>& rhs){
-		return lhs.second > rhs.second;	
-  	}
+/* state of the evaluation of the strategies, kept across the Dijkstra runs of a solve.
+   After a full run, parent[] is a shortest path forest rooted in Bz: removing vertices
+   from Bz, or switching the arc of a Min vertex to one requiring more energy, can only
+   raise the energies, and only in the subtrees of the vertices involved */
+template<typename I>
+struct t_kasi_eval{
+	bool incremental; // false if every run is a full one
+	bool full; // true if the next run must be a full one
+	I* key; // key of the last run that reached each vertex
+	I* parent; // head of the arc out of v on its shortest path to Bz, v itself if v is in Bz
+	bool* affected;
+	vector<I> affected_list;
+	vector<I> dirty; // vertices that left Bz or switched arc since the last run
+	// Bz is maintained from the energy changes of the Dijkstra runs and the switches
+	I* count; // arcs out of each Max vertex of Bz satisfied by a zero energy
+	vector<I> changed; // vertices whose energy changed in the last run
+	vector<I> old_energy; // their energies before the run
+	vector<I> switched; // vertices of Bz that switched arc since the last update_Bz
+	SolveBudget* budget; // polled on every pop of the Dijkstra runs, see t_kasi_conf
+	t_solve_stats stats; // counters of the solve, see stats.h
 };
 
-void evaluateStrategy(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, MPGProj* rev_pi, t_nrg* energy, bool *Bz, bool *S);
-void KASI_Dijkstra(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, t_nrg *energy, bool* Bz, bool *S);
-t_nrg circle_op(t_nrg Top, t_nrg energy, t_weight w);
+// pops of a Dijkstra run between two polls of the budget of the solve
+#define KASI_POLL_PERIOD 1024
+
+template<typename I, typename W, typename Q> t_status KASI_solve(MeanPayoffGame *mpg, t_nrg B, I *energy, Q& queue, const t_kasi_conf& conf, SolverWorkspace* ws);
+template<typename I, typename W, typename Q> void evaluateStrategy(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, I* energy, bool *Bz, bool *S, Q& queue, t_kasi_eval<I>& eval);
+template<typename I, typename W, typename Q> void KASI_Dijkstra(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, I *energy, bool* Bz, bool *S, Q& queue, t_kasi_eval<I>& eval);
+template<typename I, typename W, typename Q> void KASI_Dijkstra_incremental(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, I *energy, bool* Bz, bool *S, Q& queue, t_kasi_eval<I>& eval);
 
-void refresh_revprj(MPGProj *rev_pi, t_w_arc old_arc, t_w_arc new_arc){
-	list<t_w_arc>* old_head_inarcs = rev_pi->get_arcs(old_arc.head_idx);
-	old_head_inarcs->remove(old_arc);
-	list<t_w_arc>* new_head_inarcs = rev_pi->get_arcs(new_arc.head_idx);
-	new_head_inarcs->push_front(new_arc);
+// calls @f(v, w) on the in-arcs (v,u) of the strategy projection of @pi: the Min
+// vertices choosing an arc into @u are listed by @pi, the Max vertices follow them in @rev
+template<typename I, typename W, typename F>
+inline void for_each_in_arc(MPGProj* pi, const t_rev_csr<I, W>* rev, I u, F f){
+	for(unsigned long v = pi->first_tail(u); v != MPGProj::NONE; v = pi->next_tail(v))
+		f((I)v, (W)pi->get_arc(v).weight);
+	for(I i=rev->max_first[u]; i < rev->offset[u+1]; i++)
+		f(rev->tail[i], rev->weight[i]);
 }
 
-bool positive_Bz_Max(MeanPayoffGame *mpg, t_idx v, MPGProj *pi, t_nrg* energy){	
-	t_idx size = mpg->get_n_0() + mpg->get_n_1();
-	if(v < mpg->get_n_0()){	// u is Min's node 
-		t_w_arc arc = pi->get_arcs(v)->front();
-		t_idx u = arc.head_idx;
-		if(energy[v] < circle_op(mpg->get_Top(), energy[u], arc.weight))	
-			return false;
-		else return true;
-	}else{ // u is Max's node 
-		list<t_w_arc>* arcs = mpg->get_arcs(v);	
-		list<t_w_arc>::iterator it = arcs->begin();
-		for(it; it!=arcs->end(); it++){
-			t_w_arc arc = *it;
-			t_idx u = arc.head_idx;
-			if(energy[v] >= circle_op(mpg->get_Top(),energy[u],arc.weight))	
-				return true;
-		}
-		return false;
-	}
-}
-
-bool update_Bz(MeanPayoffGame *mpg, MPGProj *pi, t_nrg* energy, bool* Bz){
-	t_idx size = mpg->get_n_0() + mpg->get_n_1();
+// Bz is the set of vertices whose zero energy is satisfied by the energies:
+// a Min vertex by its arc in @pi, a Max vertex by eval.count[v] > 0 of its arcs
+template<typename I, typename W>
+void init_Bz(MeanPayoffGame *mpg, MPGProj *pi, I* energy, bool* Bz, t_kasi_eval<I>& eval){
+	t_nrg Top = mpg->get_Top();
+	I n_0 = mpg->get_n_0();
+	I size = n_0 + mpg->get_n_1();
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	for(I v=0; v < size; v++){
+		if(v < n_0){
+			const t_w_arc& arc = pi->get_arc(v);
+			Bz[v] = energy[v] == 0 && circle_op(Top, energy[arc.head_idx], (W)arc.weight) == 0;
+			continue;
+		}
+		eval.count[v] = 0;
+		for(I a=csr->offset[v]; a < csr->offset[v+1]; a++)
+			if(circle_op(Top, energy[csr->head[a]], csr->weight[a]) == 0) eval.count[v]++;
+		Bz[v] = energy[v] == 0 && eval.count[v] > 0;
+	}
+}
+
+// removes from Bz the vertices whose zero energy is no longer satisfied after the
+// energy changes of the last Dijkstra run and the switches of @eval.switched, and
+// appends them to @eval.dirty. Energies only rise and the energies of Bz stay 0, so
+// only the in-arcs of the changed vertices are checked
+template<typename I, typename W>
+bool update_Bz(MeanPayoffGame *mpg, MPGProj *pi, I* energy, bool* Bz, t_kasi_eval<I>& eval){
+	t_nrg Top = mpg->get_Top();
+	I n_0 = mpg->get_n_0();
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
 	bool change = false;
-	for(t_idx v=0; v < size; v++)
-		if(Bz[v] && (energy[v] > 0 || !positive_Bz_Max(mpg, v, pi, energy))){
-			Bz[v]=false;	
-			change=true;
+	STAT_INC(eval.stats, STAT_KASI_BZ_ROUNDS);
+	auto remove = [&](I v){
+		Bz[v] = false;
+		eval.dirty.push_back(v);
+		change = true;
+	};
+	for(unsigned long i=0; i < eval.switched.size(); i++){
+		I v = eval.switched[i];
+		const t_w_arc& arc = pi->get_arc(v);
+		if(Bz[v] && circle_op(Top, energy[arc.head_idx], (W)arc.weight) > 0) remove(v);
+	}
+	eval.switched.clear();
+	for(unsigned long i=0; i < eval.changed.size(); i++){
+		I u = eval.changed[i];
+		I old = eval.old_energy[i];
+		for_each_in_arc(pi, rev, u, [&](I v, W w){
+			if(!Bz[v] || circle_op(Top, energy[u], w) == 0) return;
+			if(v < n_0) remove(v);
+			else if(circle_op(Top, old, w) == 0 && --eval.count[v] == 0) remove(v);
+		});
+	}
+	eval.changed.clear();
+	eval.old_energy.clear();
+	return change;
+}
+
+// KASI computes energies of the storage width of @mpg, 
+// I=uint32_t and W=int32_t for 32-bit games
+t_status KASI_lowerWeakUpperBound(MeanPayoffGame *mpg, t_nrg B, t_nrg *energy, const t_kasi_conf& conf){
+	if(mpg->get_width() == WIDTH_64)
+		return KASI_lowerWeakUpperBound<t_idx, t_weight>(mpg, B, energy, conf);
+	t_idx size = mpg->get_n_0() + mpg->get_n_1();
+	SolverWorkspace local;
+	t_kasi_conf c = conf;
+	if(c.workspace == NULL) c.workspace = &local;
+	uint32_t* energy32 = c.workspace->get<uint32_t>(WS_ENERGY_NARROW, size);
+	t_mem_report mem;
+	if(c.memory != NULL) c.memory = &mem;
+	t_status status = KASI_lowerWeakUpperBound<uint32_t, int32_t>(mpg, B, energy32, c);
+	widen_energy(energy32, energy, size);
+	mem.bytes[MEM_ARRAYS] += size * sizeof(t_nrg); // the energies of the caller
+	if(conf.memory != NULL) conf.memory->peak(mem);
+	return status;
+}
+
+// dispatches on the priority queue of KASI_Dijkstra, which is allocated once per solve
+template<typename I, typename W>
+t_status KASI_lowerWeakUpperBound(MeanPayoffGame *mpg, t_nrg B, I *energy, const t_kasi_conf& conf){
+	I size = mpg->get_n_0() + mpg->get_n_1();
+	SolverWorkspace local;
+	SolverWorkspace* ws = conf.workspace != NULL ? conf.workspace : &local;
+	switch(conf.queue){
+		case KASI_RADIX:{
+			RadixHeap<I> queue(size, ws);
+			return KASI_solve<I, W>(mpg, B, energy, queue, conf, ws);
+		}
+		case KASI_DARY:{
+			DaryHeap<I> queue(size, ws);
+			return KASI_solve<I, W>(mpg, B, energy, queue, conf, ws);
+		}
+		default: throw "unknown KASI priority queue";
+	}
+}
+
+// Min's arcs below this number are scanned by a single thread
+#define KASI_PAR_MIN_ARCS (1 << 16)
+
+/* improvement phase of KASI: the improving arcs of the Min vertices are detected by
+   @threads threads on ranges of vertices with about the same number of arcs, then the
+   switches are committed into the strategy in the order of the vertices, so that the
+   result does not depend on the number of threads. The threads live as long as the scan
+   and wait for the rounds posted by run() */
+template<typename I, typename W>
+struct t_kasi_scan{
+	const t_csr<I, W>* csr;
+	t_nrg Top;
+	I n_0;
+	I* energy;
+	t_kasi_switch rule;
+	unsigned long seed;
+	unsigned long round;
+	unsigned int threads;
+	vector<I> first; // first vertex of each range, threads+1 entries
+	vector<vector<t_w_arc> > switches; // of each range
+	vector<thread> workers; // scan the ranges 1..threads-1, run() scans the range 0
+	mutex lock;
+	condition_variable wake; // of the workers, on a new round or on stop
+	condition_variable done; // of run(), once the workers finished the round
+	unsigned long posted = 0; // rounds posted to the workers
+	unsigned int pending = 0; // workers still scanning the last posted round
+	bool stop = false;
+
+	t_kasi_scan(MeanPayoffGame *mpg, I* energy, const t_kasi_conf& conf){
+		this->csr = mpg->get_csr<I, W>();
+		this->Top = mpg->get_Top();
+		this->n_0 = mpg->get_n_0();
+		this->energy = energy;
+		this->rule = conf.switching;
+		if(this->rule >= KASI_NUM_SWITCHES) throw "unknown KASI switching rule";
+		this->seed = conf.seed;
+		this->round = 0;
+		this->threads = conf.threads > 0 ? conf.threads : thread::hardware_concurrency();
+		I m_0 = this->csr->offset[this->n_0];
+		if(this->threads == 0 || m_0 < KASI_PAR_MIN_ARCS) this->threads = 1;
+		for(unsigned int t=0; t < this->threads; t++){
+			I target = (uint64_t)m_0 * t / this->threads;
+			this->first.push_back(lower_bound(this->csr->offset, this->csr->offset + this->n_0, target) - this->csr->offset);
+		}
+		this->first.push_back(this->n_0);
+		this->switches.resize(this->threads);
+		for(unsigned int t=1; t < this->threads; t++)
+			this->workers.push_back(thread(&t_kasi_scan::worker, this, t));
+	}
+
+	~t_kasi_scan(){
+		{
+			lock_guard<mutex> guard(this->lock);
+			this->stop = true;
 		}
-	return change; // no change
+		this->wake.notify_all();
+		for(unsigned int t=0; t < this->workers.size(); t++) this->workers[t].join();
+	}
+
+	t_kasi_scan(const t_kasi_scan&) = delete;
+	t_kasi_scan& operator=(const t_kasi_scan&) = delete;
+
+	// the improving arc of the Min vertex @v picked by the rule, top if none
+	I improving_arc(I v){
+		const I top = numeric_limits<I>::max();
+		I picked = top;
+		I picked_val = 0;
+		unsigned long k = 0; // improving arcs seen so far
+		for(I a=this->csr->offset[v]; a < this->csr->offset[v+1]; a++){
+			I val = circle_op(this->Top, this->energy[this->csr->head[a]], this->csr->weight[a]);
+			if(this->energy[v] >= val) continue;
+			k++;
+			if(this->rule == KASI_SWITCH_ALL) picked = a;
+			else if(this->rule == KASI_SWITCH_BEST){
+				if(picked == top || val > picked_val){
+					picked = a;
+					picked_val = val;
+				}
+			}else if(mix(this->seed, this->round, v, k) % k == 0) picked = a; // reservoir sampling
+		}
+		return picked;
+	}
+
+	// splitmix64 finalizer of the arguments
+	static uint64_t mix(uint64_t seed, uint64_t round, uint64_t v, uint64_t k){
+		uint64_t x = seed ^ (round * 0x9E3779B97F4A7C15ULL) ^ (v * 0xBF58476D1CE4E5B9ULL) ^ (k * 0x94D049BB133111EBULL);
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	void scan_range(unsigned int t){
+		const I top = numeric_limits<I>::max();
+		vector<t_w_arc>& sw = this->switches[t];
+		sw.clear();
+		for(I v=this->first[t]; v < this->first[t+1]; v++){
+			if(this->energy[v] == top) continue;
+			I a = improving_arc(v);
+			if(a == top) continue;
+			t_w_arc arc;
+			arc.arc_idx = a;
+			arc.tail_idx = v;
+			arc.head_idx = this->csr->head[a];
+			arc.weight = this->csr->weight[a];
+			sw.push_back(arc);
+		}
+	}
+
+	// main loop of the thread of range @t: scans it once per posted round until stop
+	void worker(unsigned int t){
+		unsigned long seen = 0;
+		unique_lock<mutex> guard(this->lock);
+		while(true){
+			this->wake.wait(guard, [&]{ return this->stop || this->posted != seen; });
+			if(this->stop) break;
+			seen = this->posted;
+			guard.unlock();
+			scan_range(t);
+			guard.lock();
+			if(--this->pending == 0) this->done.notify_one();
+		}
+	}
+
+	// switches the improving Min vertices of @pi and appends them to @dirty,
+	// returns their number, 0 if there is no improving arc
+	unsigned long run(MPGProj* pi, vector<I>& dirty){
+		if(!this->workers.empty()){
+			lock_guard<mutex> guard(this->lock);
+			this->pending = this->workers.size();
+			this->posted++;
+		}
+		this->wake.notify_all();
+		scan_range(0);
+		if(!this->workers.empty()){
+			unique_lock<mutex> guard(this->lock);
+			this->done.wait(guard, [&]{ return this->pending == 0; });
+		}
+		unsigned long switched = 0;
+		for(unsigned int t=0; t < this->threads; t++){
+			for(unsigned long i=0; i < this->switches[t].size(); i++){
+				const t_w_arc& arc = this->switches[t][i];
+				pi->set_arc(arc.tail_idx, arc);
+				dirty.push_back(arc.tail_idx);
+			}
+			switched += this->switches[t].size();
+		}
+		this->round++;
+		return switched;
+	}
+};
+
+// raises @conf.memory, if not NULL, to the footprint of a solve on the strategy @pi
+template<typename I, typename W>
+static void KASI_report_memory(MeanPayoffGame *mpg, MPGProj* pi, SolverWorkspace* ws, const t_kasi_eval<I>& eval, const t_kasi_scan<I, W>& scan, const t_kasi_conf& conf){
+	if(conf.memory == NULL) return;
+	I size = mpg->get_n_0() + mpg->get_n_1();
+	t_mem_report mem;
+	mpg->memory(&mem);
+	mem.bytes[MEM_PROJ] = pi->footprint();
+	mem.bytes[MEM_ARRAYS] = size * sizeof(I) + ws->footprint(WS_KEY) + ws->footprint(WS_PARENT) + ws->footprint(WS_AFFECTED)
+		+ ws->footprint(WS_BZ_COUNT) + ws->footprint(WS_BZ) + ws->footprint(WS_S);
+	mem.bytes[MEM_QUEUES] = ws->footprint(WS_PQ_KEY) + ws->footprint(WS_PQ_POS) + ws->footprint(WS_PQ_AUX)
+		+ sizeof(I) * (eval.affected_list.capacity() + eval.dirty.capacity() + eval.changed.capacity()
+		+ eval.old_energy.capacity() + eval.switched.capacity() + scan.first.capacity());
+	for(unsigned long t=0; t < scan.switches.size(); t++) mem.bytes[MEM_QUEUES] += scan.switches[t].capacity() * sizeof(t_w_arc);
+	mem_report(conf.memory, mem);
 }
 
-void KASI_lowerWeakUpperBound(MeanPayoffGame *mpg, t_nrg B, t_nrg *energy){
+// \top is the max value of I, so that B is capped to the max value of I minus one
+template<typename I, typename W, typename Q>
+t_status KASI_solve(MeanPayoffGame *mpg, t_nrg B, I *energy, Q& queue, const t_kasi_conf& conf, SolverWorkspace* ws){
+	const I top = numeric_limits<I>::max();
+	if(B >= top) B = top - 1;
 	MPGProj pi = MPGProj(mpg);
 	pi.init_arbitrary(mpg, MIN);
-	MPGProj rev_pi = MPGProj(mpg);
-	rev_pi.init_reverse(&pi);
-	t_idx size = mpg->get_n_0() + mpg->get_n_1();
+	I size = mpg->get_n_0() + mpg->get_n_1();
 	fill_n(energy, size, 0);
-	bool Bz[size];
-	fill_n(Bz, size, true);
-	update_Bz(mpg, &pi, energy, Bz);
-	bool S[size];
+	t_kasi_eval<I> eval;
+	eval.incremental = conf.incremental;
+	eval.full = true;
+	SolveBudget budget(conf.cancel, conf.deadline, KASI_POLL_PERIOD);
+	eval.budget = &budget;
+	eval.key = ws->get<I>(WS_KEY, size);
+	eval.parent = ws->get<I>(WS_PARENT, size);
+	eval.affected = ws->get<bool>(WS_AFFECTED, size);
+	fill_n(eval.affected, size, false);
+	eval.count = ws->get<I>(WS_BZ_COUNT, size);
+	bool* Bz = ws->get<bool>(WS_BZ, size);
+	init_Bz<I, W>(mpg, &pi, energy, Bz, eval);
+	bool* S = ws->get<bool>(WS_S, size);
 	fill_n(S, size, false);
+	t_kasi_scan<I, W> scan(mpg, energy, conf);
 	bool improvement = true; 
 	while(improvement){
-		evaluateStrategy(mpg, B, &pi, &rev_pi, energy, Bz, S);
-		improvement = false;		
-		for(t_idx v=0; v < mpg->get_n_0(); v++){ // O(m)
-			if(energy[v] < ULONG_MAX){ // v is the tail
-				list<t_w_arc> *arcs = mpg->get_arcs(v);
-				list<t_w_arc>::iterator it = arcs->begin();
-				for(it; it!=arcs->end();it++){
-					t_w_arc	arc = *it;
-					t_idx u = arc.head_idx;
-					if(energy[v] < circle_op(mpg->get_Top(),energy[u],arc.weight)){
-						t_w_arc old_arc = pi.get_arcs(v)->front();
-						pi.set_arc(v,arc);
-						refresh_revprj(&rev_pi, old_arc, arc);
-						improvement = true;	
-					}
-				} 
-			}
+		evaluateStrategy<I, W>(mpg, B, &pi, energy, Bz, S, queue, eval);
+		// the energies of the last complete Dijkstra run only rise towards the least fixpoint
+		if(budget.get_status() != SOLVE_CONVERGED){
+			STAT_REPORT(conf.stats, eval.stats);
+			KASI_report_memory(mpg, &pi, ws, eval, scan, conf);
+			return budget.get_status();
 		}
+		unsigned long switched = scan.run(&pi, eval.dirty);
+		STAT_ADD(eval.stats, STAT_KASI_SWITCHES, switched);
+		improvement = switched > 0;
 	}
+	STAT_REPORT(conf.stats, eval.stats);
+	KASI_report_memory(mpg, &pi, ws, eval, scan, conf);
+	if(conf.strategy != NULL) // Min's strategy certifies the energies, see cert.h
+		for(I v=0; v < mpg->get_n_0(); v++) conf.strategy[v] = pi.get_arc(v).arc_idx;
+	return SOLVE_CONVERGED;
 }
 
-void evaluateStrategy(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, MPGProj* rev_pi, t_nrg* energy, bool *Bz, bool *S){	
+// the first run is a full one, the next ones only recompute the energies of the
+// vertices whose shortest path to Bz went through the vertices of @eval.dirty
+template<typename I, typename W, typename Q>
+void evaluateStrategy(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, I* energy, bool *Bz, bool *S, Q& queue, t_kasi_eval<I>& eval){	
+	for(unsigned long i=0; i < eval.dirty.size(); i++)
+		if(Bz[eval.dirty[i]]) eval.switched.push_back(eval.dirty[i]);
 	bool Bz_changing = true;
 	while(Bz_changing){
-		KASI_Dijkstra(mpg, B, rev_pi, energy, Bz, S);
-		Bz_changing = update_Bz(mpg, pi, energy, Bz);
+		if(eval.full || !eval.incremental)
+			KASI_Dijkstra<I, W>(mpg, B, pi, energy, Bz, S, queue, eval);
+		else
+			KASI_Dijkstra_incremental<I, W>(mpg, B, pi, energy, Bz, S, queue, eval);
+		if(eval.budget->get_status() != SOLVE_CONVERGED) return; // the run left the energies as they were
+		eval.full = false;
+		eval.dirty.clear();
+		Bz_changing = update_Bz<I, W>(mpg, pi, energy, Bz, eval);
 	}
 }
 
-void KASI_Dijkstra(MeanPayoffGame *mpg, t_nrg B, MPGProj* rev_pi, t_nrg *energy, bool* Bz, bool *S){
-	priority_queue<pair<t_idx, t_key>, 
-		std::vector<pair<t_idx, t_key> >, rev_paircomparison> Q; // min priority queue
-	t_idx size = mpg->get_n_0() + mpg->get_n_1();
-	bool enqueued[size];
-	fill_n(enqueued, size, false);
-	t_key key[size];
-	fill_n(key, size, ULONG_MAX);
-	for(t_idx v=0; v<size; v++){
-		if(energy[v]<ULONG_MAX)
+// the in-arcs of the strategy projection are read from @pi and the game's reverse index.
+// keys are computed with 64-bit arithmetic, so keys that do not fit in I are never stored.
+// @queue is an empty min priority queue with decrease-key, see pqueue.h
+template<typename I, typename W, typename Q>
+void KASI_Dijkstra(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, I *energy, bool* Bz, bool *S, Q& queue, t_kasi_eval<I>& eval){
+	const I top = numeric_limits<I>::max();
+	I size = mpg->get_n_0() + mpg->get_n_1();
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
+	I* key = eval.key;
+	STAT_INC(eval.stats, STAT_KASI_DIJKSTRAS);
+	fill_n(key, size, top);
+	for(I v=0; v<size; v++){
+		if(energy[v]<top)
 			S[v] = true;
 		if(Bz[v]){
 			key[v] = 0;
-			pair<t_idx, t_key> v_key(v, key[v]);
-			Q.push(v_key);
-			enqueued[v] = true;
-		}
-	}
-	while(!Q.empty()){
-		pair<t_idx, t_key> top_u_key = Q.top();	
-		t_idx u = top_u_key.first;
-		Q.pop(); enqueued[u] = false;
-		list<t_w_arc> *arcs = rev_pi->get_arcs(u);
-		list<t_w_arc>::iterator it = arcs->begin();
-		for(it; it!=arcs->end(); it++){
-			t_w_arc arc = *it;
-			t_idx v = arc.tail_idx;
+			eval.parent[v] = v;
+			queue.push(v, key[v]);
+			STAT_INC(eval.stats, STAT_KASI_HEAP_PUSHES);
+		}
+	}
+	while(!queue.empty()){
+		if(eval.budget->expired()) return;
+		I u = queue.pop();
+		STAT_INC(eval.stats, STAT_KASI_HEAP_POPS);
+		for_each_in_arc(pi, rev, u, [&](I v, W w){
+			STAT_INC(eval.stats, STAT_KASI_RELAXATIONS);
 			if(S[v] && !Bz[v]){
-				t_key tmp = key[u] - arc.weight - energy[v] + energy[u];
+				uint64_t tmp = (uint64_t)key[u] - (uint64_t)(int64_t)w 
+					- energy[v] + energy[u];
 				if(tmp<key[v]){
 					key[v] = tmp;	
-					if(!enqueued[v]){
-						pair<t_idx, t_key> v_key(v, key[v]);	
-						Q.push(v_key);
-						enqueued[v]=true;
+					eval.parent[v] = u;
+					if(queue.contains(v)){
+						queue.decrease(v, key[v]);
+						STAT_INC(eval.stats, STAT_KASI_DECREASES);
+					}else{
+						queue.push(v, key[v]);
+						STAT_INC(eval.stats, STAT_KASI_HEAP_PUSHES);
 					}
 				}
 			}
+		});
+	}
+	for(I v=0; v<size; v++){
+		I old = energy[v];
+		if(S[v] && key[v]<top && ((uint64_t)energy[v]+key[v])<=B)
+			energy[v] += key[v];
+		else{
+			energy[v] = top;
+			S[v] = false;
+		}
+		if(energy[v] != old){
+			eval.changed.push_back(v);
+			eval.old_energy.push_back(old);
+		}
+	}
+}
+
+// same result as KASI_Dijkstra when the energies can only rise since the last run.
+// The affected vertices, @eval.dirty and their descendants in the shortest path forest,
+// are seeded with their best arc towards an unaffected vertex, whose key is 0, and the
+// Dijkstra run is restricted to them: the other energies and parents are unchanged.
+template<typename I, typename W, typename Q>
+void KASI_Dijkstra_incremental(MeanPayoffGame *mpg, t_nrg B, MPGProj* pi, I *energy, bool* Bz, bool *S, Q& queue, t_kasi_eval<I>& eval){
+	const I top = numeric_limits<I>::max();
+	I n_0 = mpg->get_n_0();
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	const t_rev_csr<I, W>* rev = mpg->get_rev_csr<I, W>();
+	I* key = eval.key;
+	I* parent = eval.parent;
+	bool* affected = eval.affected;
+	vector<I>& list = eval.affected_list;
+	list.clear();
+	STAT_INC(eval.stats, STAT_KASI_DIJKSTRAS);
+	for(unsigned long i=0; i < eval.dirty.size(); i++){
+		I v = eval.dirty[i];
+		if(S[v] && !Bz[v] && !affected[v]){ // a Bz vertex keeps its subtree
+			affected[v] = true;
+			list.push_back(v);
 		}
 	}
-	for(t_idx v=0; v<size; v++){
-		if(S[v] && key[v]<ULONG_MAX && (energy[v]+key[v])<=B)
+	for(unsigned long j=0; j < list.size(); j++){
+		I u = list[j];
+		for_each_in_arc(pi, rev, u, [&](I v, W w){
+			if(S[v] && !Bz[v] && !affected[v] && parent[v] == u){
+				affected[v] = true;
+				list.push_back(v);
+			}
+		});
+	}
+	for(unsigned long j=0; j < list.size(); j++){
+		I v = list[j];
+		key[v] = top;
+		I first = v < n_0 ? pi->get_arc(v).arc_idx : csr->offset[v];
+		I last = v < n_0 ? first + 1 : csr->offset[v+1];
+		for(I a=first; a < last; a++){
+			I u = csr->head[a];
+			if(S[u] && !affected[u]){
+				uint64_t tmp = (uint64_t)energy[u] - (uint64_t)(int64_t)csr->weight[a] - energy[v];
+				if(tmp<key[v]){
+					key[v] = tmp;
+					parent[v] = u;
+				}
+			}
+		}
+		if(key[v]<top){
+			queue.push(v, key[v]);
+			STAT_INC(eval.stats, STAT_KASI_HEAP_PUSHES);
+		}
+	}
+	while(!queue.empty()){
+		if(eval.budget->expired()) return;
+		I u = queue.pop();
+		STAT_INC(eval.stats, STAT_KASI_HEAP_POPS);
+		for_each_in_arc(pi, rev, u, [&](I v, W w){
+			STAT_INC(eval.stats, STAT_KASI_RELAXATIONS);
+			if(!affected[v]) return; // unchanged vertex
+			uint64_t tmp = (uint64_t)key[u] - (uint64_t)(int64_t)w 
+				- energy[v] + energy[u];
+			if(tmp<key[v]){
+				key[v] = tmp;	
+				parent[v] = u;
+				if(queue.contains(v)){
+					queue.decrease(v, key[v]);
+					STAT_INC(eval.stats, STAT_KASI_DECREASES);
+				}else{
+					queue.push(v, key[v]);
+					STAT_INC(eval.stats, STAT_KASI_HEAP_PUSHES);
+				}
+			}
+		});
+	}
+	for(unsigned long j=0; j < list.size(); j++){
+		I v = list[j];
+		affected[v] = false;
+		I old = energy[v];
+		if(key[v]<top && ((uint64_t)energy[v]+key[v])<=B)
 			energy[v] += key[v];
 		else{
-			energy[v] = ULONG_MAX;
+			energy[v] = top;
 			S[v] = false;
 		}
+		if(energy[v] != old){
+			eval.changed.push_back(v);
+			eval.old_energy.push_back(old);
+		}
+	}
+}
+
+template<typename I, typename W>
+struct KASI_kernels<I, W>::t_state{
+	MeanPayoffGame* mpg;
+	t_nrg B;
+	MPGProj pi;
+	SolverWorkspace ws;
+	SolveBudget budget;
+	t_kasi_eval<I> eval;
+	I* energy;
+	bool* Bz;
+	bool* S;
+	RadixHeap<I>* radix; // the queue of the runs, the other one is NULL
+	DaryHeap<I>* dary;
+
+	t_state(MeanPayoffGame* mpg) : pi(mpg), budget(NULL, NO_DEADLINE, KASI_POLL_PERIOD){}
+};
+
+template<typename I, typename W>
+KASI_kernels<I, W>::KASI_kernels(MeanPayoffGame *mpg, t_kasi_queue queue){
+	const I top = numeric_limits<I>::max();
+	I size = mpg->get_n_0() + mpg->get_n_1();
+	mpg->get_rev_csr<I, W>(); // checks the width
+	t_state* s = this->state = new t_state(mpg);
+	s->mpg = mpg;
+	s->B = mpg->get_Top() + 1 >= top ? top - 1 : mpg->get_Top() + 1;
+	s->pi.init_arbitrary(mpg, MIN);
+	SolverWorkspace* ws = &s->ws;
+	s->eval.incremental = false;
+	s->eval.full = true;
+	s->eval.budget = &s->budget;
+	s->eval.key = ws->get<I>(WS_KEY, size);
+	s->eval.parent = ws->get<I>(WS_PARENT, size);
+	s->eval.affected = ws->get<bool>(WS_AFFECTED, size);
+	fill_n(s->eval.affected, size, false);
+	s->eval.count = ws->get<I>(WS_BZ_COUNT, size);
+	s->energy = ws->get<I>(WS_ENERGY_NARROW, size);
+	s->Bz = ws->get<bool>(WS_BZ, size);
+	s->S = ws->get<bool>(WS_S, size);
+	s->radix = queue == KASI_RADIX ? new RadixHeap<I>(size, ws) : NULL;
+	s->dary = queue == KASI_DARY ? new DaryHeap<I>(size, ws) : NULL;
+	if(s->radix == NULL && s->dary == NULL){
+		delete s;
+		throw "unknown KASI priority queue";
 	}
+	reset();
+}
+
+template<typename I, typename W>
+KASI_kernels<I, W>::~KASI_kernels(){
+	delete this->state->radix;
+	delete this->state->dary;
+	delete this->state;
+}
+
+template<typename I, typename W>
+void KASI_kernels<I, W>::reset(){
+	t_state* s = this->state;
+	I size = s->mpg->get_n_0() + s->mpg->get_n_1();
+	fill_n(s->energy, size, 0);
+	fill_n(s->S, size, false);
+	s->eval.dirty.clear();
+	s->eval.changed.clear();
+	s->eval.old_energy.clear();
+	s->eval.switched.clear();
+	init_Bz<I, W>(s->mpg, &s->pi, s->energy, s->Bz, s->eval);
+}
+
+template<typename I, typename W>
+void KASI_kernels<I, W>::dijkstra(){
+	t_state* s = this->state;
+	if(s->radix != NULL) KASI_Dijkstra<I, W>(s->mpg, s->B, &s->pi, s->energy, s->Bz, s->S, *s->radix, s->eval);
+	else KASI_Dijkstra<I, W>(s->mpg, s->B, &s->pi, s->energy, s->Bz, s->S, *s->dary, s->eval);
+}
+
+template<typename I, typename W>
+bool KASI_kernels<I, W>::update_Bz(){
+	t_state* s = this->state;
+	return ::update_Bz<I, W>(s->mpg, &s->pi, s->energy, s->Bz, s->eval);
+}
+
+template<typename I, typename W>
+const I* KASI_kernels<I, W>::get_energy(){
+	return this->state->energy;
+}
+
+template class KASI_kernels<uint32_t, int32_t>;
+template class KASI_kernels<t_idx, t_weight>;
+
+template t_status KASI_lowerWeakUpperBound<uint32_t, int32_t>(MeanPayoffGame *mpg, t_nrg B, uint32_t *energy, const t_kasi_conf& conf);
+template t_status KASI_lowerWeakUpperBound<t_idx, t_weight>(MeanPayoffGame *mpg, t_nrg B, t_idx *energy, const t_kasi_conf& conf);
+
+static const char* KASI_QUEUE_NAMES[KASI_NUM_QUEUES] = {"radix", "dary"};
+
+t_kasi_queue KASI_queue_from_string(const char* name){
+	for(int q=0; q < KASI_NUM_QUEUES; q++)
+		if(string(name) == KASI_QUEUE_NAMES[q]) return (t_kasi_queue) q;
+	throw "unknown KASI priority queue";
+}
+
+const char* KASI_queue_name(t_kasi_queue queue){
+	assert(queue < KASI_NUM_QUEUES);
+	return KASI_QUEUE_NAMES[queue];
+}
+
+static const char* KASI_SWITCH_NAMES[KASI_NUM_SWITCHES] = {"all", "best", "random"};
+
+t_kasi_switch KASI_switch_from_string(const char* name){
+	for(int r=0; r < KASI_NUM_SWITCHES; r++)
+		if(string(name) == KASI_SWITCH_NAMES[r]) return (t_kasi_switch) r;
+	throw "unknown KASI switching rule";
 }
 
-/* circle_op() computes the circle-minus operator, see [Brim2011], we assumee ULONG_MAX=\top */
-t_nrg circle_op(t_nrg Top, t_nrg energy, t_weight w){
-	t_weight abs_w = labs(w);
-	if(energy == ULONG_MAX || (w<0 && energy+abs_w>Top) 
-			|| (w>=0 && energy > abs_w && energy-abs_w > Top)) 
-		return ULONG_MAX;
-	if(w<0) return energy+abs_w;
-	if(w>=0 && energy > abs_w) return energy-abs_w;
-	else return 0;
+const char* KASI_switch_name(t_kasi_switch rule){
+	assert(rule < KASI_NUM_SWITCHES);
+	return KASI_SWITCH_NAMES[rule];
 }
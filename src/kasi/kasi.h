@@ -16,7 +16,54 @@
 #define KASI
 
 #include "../conf.h"
+#include "../mpg/mpg.h"
+#include "../workspace/workspace.h"
+#include "../budget/budget.h"
+#include "../stats/stats.h"
 
-void KASI_lowerWeakUpperBound(MeanPayoffGame *mpg, t_nrg B, t_nrg *energy);
+// priority queues of KASI_Dijkstra, see pqueue.h
+enum t_kasi_queue{
+	KASI_RADIX=0, // monotone radix heap
+	KASI_DARY, // indexed 4-ary heap
+	KASI_NUM_QUEUES
+};
+
+// rules picking the arc a Min vertex switches to among its improving arcs
+enum t_kasi_switch{
+	KASI_SWITCH_ALL=0, // every improving vertex switches to its last improving arc
+	KASI_SWITCH_BEST, // to the arc requiring the most energy
+	KASI_SWITCH_RANDOM, // to an improving arc picked at random
+	KASI_NUM_SWITCHES
+};
+
+// options of KASI_lowerWeakUpperBound
+struct t_kasi_conf{
+	t_kasi_queue queue = KASI_RADIX;
+	bool incremental = true; // false reruns KASI_Dijkstra on all the vertices for every evaluation
+	t_kasi_switch switching = KASI_SWITCH_ALL;
+	unsigned long seed = 0; // of KASI_SWITCH_RANDOM, the switches do not depend on the threads
+	unsigned int threads = 1; // threads of the improvement scan, 0 uses all the cores
+	SolverWorkspace* workspace = NULL; // scratch buffers, NULL allocates them for the solve
+	t_idx* strategy = NULL; // if not NULL, receives the arc index chosen by each Min vertex
+	const bool* cancel = NULL; // polled by the solve, which stops early once *cancel is set
+	t_deadline deadline = NO_DEADLINE; // the solve stops early once it is past, see budget.h
+	t_solve_stats* stats = NULL; // if not NULL, the counters of the solve are added to it, see stats.h
+	t_mem_report* memory = NULL; // if not NULL, it is raised to the footprint of the solve, see mem.h
+};
+
+// returns the queue named @name ("radix", "dary")
+t_kasi_queue KASI_queue_from_string(const char* name);
+const char* KASI_queue_name(t_kasi_queue queue);
+// returns the switching rule named @name ("all", "best", "random")
+t_kasi_switch KASI_switch_from_string(const char* name);
+const char* KASI_switch_name(t_kasi_switch rule);
+
+// energies of width I, the game must be stored with the same width (I,W). The energies of
+// a solve stopped early by @conf.cancel or @conf.deadline are below the least fixpoint
+// and no strategy is written
+template<typename I, typename W> 
+t_status KASI_lowerWeakUpperBound(MeanPayoffGame *mpg, t_nrg B, I *energy, const t_kasi_conf& conf = t_kasi_conf());
+// energies of width t_nrg, ULONG_MAX stands for \top
+t_status KASI_lowerWeakUpperBound(MeanPayoffGame *mpg, t_nrg B, t_nrg *energy, const t_kasi_conf& conf = t_kasi_conf());
 
 #endif
@@ -0,0 +1,47 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Internals of KASI exposed to the microbenchmarks of src/bench, not part of the
+*  solver API of kasi.h.
+*****************************************************************************************/
+
+#ifndef KASI_IMPL
+#define KASI_IMPL
+
+#include "kasi.h"
+
+/* the kernels of the strategy evaluation on the fixed strategy of Min choosing its first
+   arcs, for the microbenchmarks of src/bench: reset() sets the energies to 0, dijkstra()
+   runs a full KASI_Dijkstra from them, and update_Bz() updates Bz after the energy
+   changes of the last dijkstra(). The game must be stored with the width (I,W) */
+template<typename I, typename W>
+class KASI_kernels{
+	public:
+	KASI_kernels(MeanPayoffGame *mpg, t_kasi_queue queue);
+	~KASI_kernels();
+	void reset();
+	void dijkstra();
+	bool update_Bz();
+	const I* get_energy();
+
+	private:
+	struct t_state;
+	t_state* state;
+	KASI_kernels(const KASI_kernels&) = delete;
+	KASI_kernels& operator=(const KASI_kernels&) = delete;
+};
+
+#endif
@@ -0,0 +1,192 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Min priority queues of vertices with decrease-key for KASI_Dijkstra.
+*  The reduced weights of the Dijkstra runs of KASI are non negative, so the keys
+*  pushed or decreased are never below the last popped key: RadixHeap relies on it
+*  for its complexity, a lower key costs a rebucketing of all its vertices. A run starts
+*  from an empty queue, which RadixHeap restarts from key 0, so its seeds may be pushed
+*  in any order.
+*  Both classes are created once per solve on arrays of the solver workspace, reused
+*  by every Dijkstra run, and share the same interface:
+*   push(v, key): inserts vertex v, which must not be contained;
+*   decrease(v, key): lowers the key of the contained vertex v;
+*   pop(): removes and returns a vertex of min key; empty(); contains(v).
+*****************************************************************************************/
+
+#ifndef KASI_PQUEUE
+#define KASI_PQUEUE
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+#include <stdint.h>
+#include "../workspace/workspace.h"
+
+/* monotone radix heap: bucket b > 0 holds the keys whose highest bit differing
+   from the last popped key is b-1, bucket 0 the keys equal to it */
+template<typename I>
+class RadixHeap{
+	private:
+		static constexpr int NUM_BUCKETS = 65;
+		std::vector<I> buckets[NUM_BUCKETS];
+		I* key;
+		I* pos; // index of each vertex in its bucket
+		unsigned char* bucket_of; // NUM_BUCKETS if not contained
+		I last; // last popped key
+		I len;
+		int bucket(I k){
+			return k == this->last ? 0 : 64 - __builtin_clzll((unsigned long long) (k ^ this->last));
+		}
+		void insert(I v, int b){
+			this->bucket_of[v] = b;
+			this->pos[v] = this->buckets[b].size();
+			this->buckets[b].push_back(v);
+		}
+		// moves all the vertices to the buckets relative to the new last popped key @k
+		void rebase(I k){
+			std::vector<I> all;
+			for(int b=0; b < NUM_BUCKETS; b++){
+				all.insert(all.end(), this->buckets[b].begin(), this->buckets[b].end());
+				this->buckets[b].clear();
+			}
+			this->last = k;
+			for(unsigned long i=0; i < all.size(); i++) insert(all[i], bucket(this->key[all[i]]));
+		}
+		void remove(I v){
+			std::vector<I>& bkt = this->buckets[this->bucket_of[v]];
+			I moved = bkt.back();
+			bkt[this->pos[v]] = moved;
+			this->pos[moved] = this->pos[v];
+			bkt.pop_back();
+		}
+	public:
+		RadixHeap(I size, SolverWorkspace* ws){
+			this->key = ws->get<I>(WS_PQ_KEY, size);
+			this->pos = ws->get<I>(WS_PQ_POS, size);
+			this->bucket_of = ws->get<unsigned char>(WS_PQ_AUX, size);
+			std::fill_n(this->bucket_of, size, NUM_BUCKETS);
+			this->last = 0;
+			this->len = 0;
+		}
+		bool empty(){ return this->len == 0; }
+		bool contains(I v){ return this->bucket_of[v] != NUM_BUCKETS; }
+		void push(I v, I k){
+			assert(!contains(v));
+			// an empty heap starts over from key 0, below all the keys, so that the seeds
+			// of a run pushed in any order never rebucket the heap
+			if(this->len == 0) this->last = 0;
+			else if(k < this->last) rebase(k);
+			this->key[v] = k;
+			insert(v, bucket(k));
+			this->len++;
+		}
+		void decrease(I v, I k){
+			assert(contains(v) && k <= this->key[v]);
+			remove(v);
+			if(k < this->last) rebase(k);
+			this->key[v] = k;
+			insert(v, bucket(k));
+		}
+		I pop(){
+			assert(this->len > 0);
+			if(this->buckets[0].empty()){
+				// the min of the first non empty bucket becomes last, its vertices
+				// move to lower buckets
+				int b = 1;
+				while(this->buckets[b].empty()) b++;
+				std::vector<I>& bkt = this->buckets[b];
+				I min_key = this->key[bkt[0]];
+				for(unsigned long i=1; i < bkt.size(); i++) min_key = std::min(min_key, this->key[bkt[i]]);
+				this->last = min_key;
+				for(unsigned long i=0; i < bkt.size(); i++) insert(bkt[i], bucket(this->key[bkt[i]]));
+				bkt.clear();
+			}
+			I v = this->buckets[0].back();
+			this->buckets[0].pop_back();
+			this->bucket_of[v] = NUM_BUCKETS;
+			this->len--;
+			return v;
+		}
+};
+
+/* indexed D-ary min heap */
+template<typename I, int D = 4>
+class DaryHeap{
+	private:
+		I* heap;
+		I* key;
+		I* pos; // index of each vertex in heap, NOT_IN if not contained
+		I len;
+		static constexpr I NOT_IN = std::numeric_limits<I>::max();
+		void place(I v, I i){
+			this->heap[i] = v;
+			this->pos[v] = i;
+		}
+		void sift_up(I v, I i){
+			while(i > 0){
+				I parent = (i - 1) / D;
+				if(this->key[this->heap[parent]] <= this->key[v]) break;
+				place(this->heap[parent], i);
+				i = parent;
+			}
+			place(v, i);
+		}
+		void sift_down(I v, I i){
+			while(true){
+				I first = i * D + 1;
+				if(first >= this->len) break;
+				I best = first;
+				I last = std::min((I) (first + D), this->len);
+				for(I c=first+1; c < last; c++)
+					if(this->key[this->heap[c]] < this->key[this->heap[best]]) best = c;
+				if(this->key[this->heap[best]] >= this->key[v]) break;
+				place(this->heap[best], i);
+				i = best;
+			}
+			place(v, i);
+		}
+	public:
+		DaryHeap(I size, SolverWorkspace* ws){
+			this->heap = ws->get<I>(WS_PQ_AUX, size);
+			this->key = ws->get<I>(WS_PQ_KEY, size);
+			this->pos = ws->get<I>(WS_PQ_POS, size);
+			std::fill_n(this->pos, size, NOT_IN);
+			this->len = 0;
+		}
+		bool empty(){ return this->len == 0; }
+		bool contains(I v){ return this->pos[v] != NOT_IN; }
+		void push(I v, I k){
+			assert(!contains(v));
+			this->key[v] = k;
+			sift_up(v, this->len++);
+		}
+		void decrease(I v, I k){
+			assert(contains(v) && k <= this->key[v]);
+			this->key[v] = k;
+			sift_up(v, this->pos[v]);
+		}
+		I pop(){
+			assert(this->len > 0);
+			I v = this->heap[0];
+			this->pos[v] = NOT_IN;
+			if(--this->len > 0) sift_down(this->heap[this->len], 0);
+			return v;
+		}
+};
+
+#endif
@@ -19,110 +19,558 @@
 ***********************************************/
 
 #include <iostream>
-#include <sys/time.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <filesystem>
+#include <climits>
+#include <cstdio>
 #include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include <getopt.h>
 #include "conf.h"
 #include "mpg/mpg.h"
 #include "VI/VI.h"
 #include "kasi/kasi.h"
+#include "cert/cert.h"
+#include "portfolio/portfolio.h"
 
 using namespace std;
 
-//const char* OUTPUT_FILE = "data/output.dat";
-//const bool VERBOSE_MODE = false;
-const string INPUT_FILE_MPG = "data/pg_mpg.dat";
-const unsigned int NUM_TESTS = 5;
+const string INPUT_FILE_MPG = "data/pg_mpg.dat"; // input when no file is given
 ofstream o_stream;
 
+// solvers of the benchmark
+enum t_engine{
+	ENGINE_VI=0,
+	ENGINE_KASI,
+	ENGINE_PORTFOLIO, // VI and KASI race, see portfolio.h
+	NUM_ENGINES
+};
+const char* ENGINE_NAMES[NUM_ENGINES] = {"vi", "kasi", "portfolio"};
+
+// validation of the energies of each timed run, timed apart from the solve
+enum t_check{
+	CHECK_NONE=0,
+	CHECK_CERT, // O(m) certificate check with Min's strategy, see cert.h
+	CHECK_VI // comparison with the energies computed by VI
+};
+const char* CHECK_NAMES[] = {"none", "cert", "vi"};
+
+enum t_format{
+	FORMAT_TEXT=0, // summary per file and engine
+	FORMAT_CSV, // one row per timed run, then one per statistic
+	FORMAT_JSON
+};
+const char* FORMAT_NAMES[] = {"text", "csv", "json"};
+
+// options of the benchmark, see usage()
+struct t_bench_conf{
+	vector<string> inputs;
+	vector<t_engine> engines;
+	unsigned int warmup = 1; // untimed runs per file and engine
+	unsigned int reps = 5; // timed runs per file and engine
+	t_check check = CHECK_CERT;
+	t_format format = FORMAT_TEXT;
+	double timeout = 0; // seconds per solve, 0 for none
+	bool print_energy = false;
+	string output; // empty for stdout
+	t_vi_conf vi;
+	t_kasi_conf kasi;
+};
+
+// a timed run
+struct t_run{
+	t_status status;
+	int winner; // engine that finished first, for the portfolio
+	double solve, verify; // seconds
+	int verified; // 1 passed, 0 failed, -1 not checked
+	unsigned long finite, top; // vertices of finite and \top energy
+	t_solve_stats stats; // counters of the solve, zero unless compiled with SOLVER_STATS
+	t_mem_report memory; // footprint of the solve, see mem.h
+};
+
+// the runs of an engine on a game
+struct t_engine_result{
+	t_engine engine;
+	vector<t_run> runs;
+};
+
+// the results of a game
+struct t_file_result{
+	string file;
+	unsigned long n_0, n_1, m;
+	t_nrg Top; // features of the game, logged with the portfolio winners for an engine selector
+	t_weight min_weight, max_weight;
+	unsigned long max_deg;
+	double load, preprocess; // seconds to read the file, and to build the indexes read by the solvers
+	vector<t_engine_result> engines;
+};
+
+// statistics of a sample
+struct t_stats{
+	double min, median, p90, p99, max, mean;
+};
+const char* STAT_NAMES[] = {"min", "median", "p90", "p99", "max", "mean"};
+
+t_bench_conf CONF;
+SolverWorkspace WORKSPACE; // scratch buffers of the solvers, reused by all the runs
+SolverWorkspace PORTFOLIO_WORKSPACE[PORTFOLIO_NUM_ENGINES]; // of each engine of the portfolio, which run at the same time
+bool FAILED = false; // a verification failed
+
 /*********************************************
 * Prototypes
 ********************************************/
-void test();
-double start_KASI(MeanPayoffGame* mpg);
+void usage(ostream& out);
+void parse_args(int argc, char** argv);
+void bench_file(const string& file, ostream& out, bool first);
 timespec time_diff(timespec start, timespec end);
 
 /********************************************
 ** KASI Algorithm Implementation main()
 *******************************************/
 int main(int argc, char** argv){
-	//o_stream.open(OUTPUT_FILE, ofstream::app);
-	test();
-	//o_stream.close();
-	return 0;
+	try{
+		parse_args(argc, argv);
+		ofstream file;
+		if(!CONF.output.empty()){
+			file.open(CONF.output);
+			if(!file) throw "cannot open the output file";
+		}
+		ostream& out = CONF.output.empty() ? cout : file;
+		if(CONF.format == FORMAT_CSV){
+			out << "file,n_0,n_1,m,Top,min_weight,max_weight,max_deg,engine,run,status,winner,load_s,preprocess_s,solve_s,verify_s,verified,finite,top";
+			for(int p=0; p < MEM_NUM_PARTS; p++) out << ",mem_" << mem_part_name((t_mem_part) p);
+			out << ",mem_total,peak_rss";
+			for(int c=0; SOLVER_STATS && c < STAT_NUM_COUNTERS; c++) out << "," << stat_name((t_stat) c);
+			out << endl;
+		}
+		if(CONF.format == FORMAT_JSON) out << "[" << endl;
+		for(unsigned long i=0; i < CONF.inputs.size(); i++)
+			bench_file(CONF.inputs[i], out, i == 0);
+		if(CONF.format == FORMAT_JSON) out << endl << "]" << endl;
+		if(CONF.format == FORMAT_TEXT){
+			unsigned long bytes = WORKSPACE.footprint(), huge = WORKSPACE.huge_footprint();
+			for(int e=0; e < PORTFOLIO_NUM_ENGINES; e++){
+				bytes += PORTFOLIO_WORKSPACE[e].footprint();
+				huge += PORTFOLIO_WORKSPACE[e].huge_footprint();
+			}
+			out << "workspace: " << bytes << " bytes, " << huge << " in huge pages" << endl;
+		}
+	}catch(const char* msg){
+		cerr << "Error: " << msg << endl;
+		return -1;
+	}
+	return FAILED ? 1 : 0;
 } 
 
 /*****************
-** default test
+** options
 *****************/
-void print_energy(unsigned long *energy, MeanPayoffGame *mpg){
-	unsigned long size = mpg->get_n_0() + mpg->get_n_1();
-	cout << "ENERGY e[v]:" << endl;
-	for(unsigned long v=0; v<size; v++){
-		string e_v = (energy[v] == ULONG_MAX) ? "T" : to_string(energy[v]);
-		cout << "e[" << v << "]=" << e_v << "; ";
-	} cout << endl;
+void usage(ostream& out){
+	out << "main usage is: main [options] [file|directory]..., default input " << INPUT_FILE_MPG << endl
+		<< "  -e, --engine vi|kasi|portfolio  engines to run, comma separated (default kasi)" << endl
+		<< "  -w, --warmup N                  untimed runs per file and engine (default 1)" << endl
+		<< "  -r, --reps N                    timed runs per file and engine (default 5)" << endl
+		<< "  -c, --check cert|vi|none        validation of each timed run (default cert)" << endl
+		<< "  -f, --format text|csv|json      output format (default text)" << endl
+		<< "  -o, --output FILE               output file (default stdout)" << endl
+		<< "  -t, --timeout SECONDS           budget of each solve, 0 for none (default 0)" << endl
+		<< "  -p, --print-energy              print the energies of the last run, text format" << endl
+		<< "      --policy lifo|fifo|priority|min_first|max_first  VI worklist policy" << endl
+		<< "      --vi-threads N              VI threads, 0 for all cores (default 1)" << endl
+		<< "      --queue radix|dary          KASI priority queue" << endl
+		<< "      --eval incremental|full     KASI strategy evaluation" << endl
+		<< "      --switch all|best|random    KASI switching rule" << endl
+		<< "      --kasi-threads N            KASI improvement scan threads, 0 for all cores (default 1)" << endl
+		<< "      --seed N                    seed of the random switching rule" << endl;
+}
+
+// returns the index of @name in @names
+int find_name(const char* name, const char** names, int num, const char* error){
+	for(int i=0; i < num; i++)
+		if(string(name) == names[i]) return i;
+	throw error;
 }
 
-void assert_energies_are_equal(unsigned long *energy, unsigned long *energy2, unsigned long size){
-	for(unsigned long u=0; u<size; u++){
-		if(energy[u]!=energy2[u]){
-			cout << "FATAL ERROR!!" << endl;
-			throw "ERROR";		
+// returns @arg as a non negative integer
+unsigned long parse_count(const char* arg){
+	char* end;
+	unsigned long x = strtoul(arg, &end, 10);
+	if(*arg == '\0' || *end != '\0' || *arg == '-') throw "invalid number";
+	return x;
+}
+
+// appends the regular files of @path, in name order if it is a directory
+void add_input(const string& path){
+	namespace fs = std::filesystem;
+	error_code ec;
+	if(!fs::is_directory(path, ec)){
+		CONF.inputs.push_back(path);
+		return;
+	}
+	vector<string> files;
+	for(const fs::directory_entry& entry : fs::directory_iterator(path, ec))
+		if(entry.is_regular_file(ec) && entry.path().filename().string()[0] != '.') files.push_back(entry.path().string());
+	if(ec) throw "cannot read an input directory";
+	sort(files.begin(), files.end());
+	CONF.inputs.insert(CONF.inputs.end(), files.begin(), files.end());
+}
+
+void parse_args(int argc, char** argv){
+	enum{OPT_POLICY=256, OPT_VI_THREADS, OPT_QUEUE, OPT_EVAL, OPT_SWITCH, OPT_KASI_THREADS, OPT_SEED};
+	static const struct option options[] = {
+		{"engine", required_argument, NULL, 'e'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"reps", required_argument, NULL, 'r'},
+		{"check", required_argument, NULL, 'c'},
+		{"format", required_argument, NULL, 'f'},
+		{"output", required_argument, NULL, 'o'},
+		{"timeout", required_argument, NULL, 't'},
+		{"print-energy", no_argument, NULL, 'p'},
+		{"policy", required_argument, NULL, OPT_POLICY},
+		{"vi-threads", required_argument, NULL, OPT_VI_THREADS},
+		{"queue", required_argument, NULL, OPT_QUEUE},
+		{"eval", required_argument, NULL, OPT_EVAL},
+		{"switch", required_argument, NULL, OPT_SWITCH},
+		{"kasi-threads", required_argument, NULL, OPT_KASI_THREADS},
+		{"seed", required_argument, NULL, OPT_SEED},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	int opt;
+	while((opt = getopt_long(argc, argv, "e:w:r:c:f:o:t:ph", options, NULL)) != -1){
+		switch(opt){
+			case 'e':{
+				stringstream list(optarg);
+				string name;
+				while(getline(list, name, ','))
+					CONF.engines.push_back((t_engine) find_name(name.c_str(), ENGINE_NAMES, NUM_ENGINES, "unknown engine"));
+			}break;
+			case 'w': CONF.warmup = parse_count(optarg); break;
+			case 'r': CONF.reps = parse_count(optarg); break;
+			case 'c': CONF.check = (t_check) find_name(optarg, CHECK_NAMES, 3, "unknown validation mode"); break;
+			case 'f': CONF.format = (t_format) find_name(optarg, FORMAT_NAMES, 3, "unknown output format"); break;
+			case 'o': CONF.output = optarg; break;
+			case 't':{
+				char* end;
+				CONF.timeout = strtod(optarg, &end);
+				if(*end != '\0' || CONF.timeout < 0) throw "invalid timeout";
+			}break;
+			case 'p': CONF.print_energy = true; break;
+			case OPT_POLICY: CONF.vi.policy = VI_policy_from_string(optarg); break;
+			case OPT_VI_THREADS: CONF.vi.threads = parse_count(optarg); break;
+			case OPT_QUEUE: CONF.kasi.queue = KASI_queue_from_string(optarg); break;
+			case OPT_EVAL:
+				if(string(optarg) != "incremental" && string(optarg) != "full") throw "unknown KASI evaluation mode";
+				CONF.kasi.incremental = string(optarg) == "incremental";
+				break;
+			case OPT_SWITCH: CONF.kasi.switching = KASI_switch_from_string(optarg); break;
+			case OPT_KASI_THREADS: CONF.kasi.threads = parse_count(optarg); break;
+			case OPT_SEED: CONF.kasi.seed = parse_count(optarg); break;
+			case 'h':
+				usage(cout);
+				exit(0);
+			default:
+				usage(cerr);
+				throw "invalid arguments";
 		}
 	}
-	cout << "OK! KASI and VI compute the same set of energies!"  << endl;
+	if(CONF.reps == 0) throw "at least one timed run is needed";
+	for(int i=optind; i < argc; i++) add_input(argv[i]);
+	if(optind == argc) CONF.inputs.push_back(INPUT_FILE_MPG);
+	if(CONF.inputs.empty()) throw "no input file";
+	if(CONF.engines.empty()) CONF.engines.push_back(ENGINE_KASI);
+	CONF.vi.workspace = &WORKSPACE;
+	CONF.kasi.workspace = &WORKSPACE;
+}
+
+/*****************
+** runs
+*****************/
+double seconds(timespec start, timespec end){
+	timespec diff = time_diff(start, end);
+	return (double) diff.tv_sec + diff.tv_nsec / 1000000000.0;
+}
+
+// validates the energies of a run, according to CONF.check. Without Min's
+// @strategy of a solver that computes none, Min's strategy is derived from the energies
+bool check_energies(MeanPayoffGame *mpg, unsigned long *energy, t_idx *strategy){
+	unsigned long size = mpg->get_n_0() + mpg->get_n_1();
+	if(CONF.check == CHECK_VI){
+		unsigned long* energy2 = WORKSPACE.get<unsigned long>(WS_ENERGY_CHECK, size);
+		t_vi_conf conf = CONF.vi;
+		conf.deadline = NO_DEADLINE;
+		VI_compute_energy(mpg, energy2, conf);
+		return equal(energy, energy + size, energy2);
+	}
+	if(strategy == NULL){
+		strategy = WORKSPACE.get<t_idx>(WS_STRATEGY, mpg->get_n_0());
+		cert_min_strategy(mpg, energy, strategy);
+	}
+	return certify_energy(mpg, energy, strategy) == CERT_STRATEGY;
 }
 
-double start_algorithms(MeanPayoffGame *mpg){
-	uint64_t diff_sec, diff_nsec;
+// solves @mpg with @engine, and validates the energies if @timed
+t_run run_engine(MeanPayoffGame *mpg, t_engine engine, bool timed){
 	struct timespec start, end;
-	pair<double, string> p; 
-	clock_gettime(CLOCK_MONOTONIC, &start);	
-	cout << "invoking KASI procedure..." << endl;
+	t_run run;
 	unsigned long size = mpg->get_n_0() + mpg->get_n_1();
-	unsigned long energy[size];	
-	KASI_lowerWeakUpperBound(mpg, mpg->get_Top()+1, energy);
-	unsigned long energy2[size];
-	VI_compute_energy(mpg, energy2);
-	assert_energies_are_equal(energy, energy2, size);
-	print_energy(energy, mpg);
-	clock_gettime(CLOCK_MONOTONIC, &end); /* mark the end time */
-	diff_sec = time_diff(start, end).tv_sec;
-	diff_nsec = time_diff(start, end).tv_nsec;
-	double time = ((double) diff_sec + (diff_nsec / 1000000000.0));
-	return time;
-}
-/*****************************************************************************************/
+	unsigned long* energy = WORKSPACE.get<unsigned long>(WS_ENERGY, size);
+	t_idx* strategy = NULL;
+	if(timed && CONF.check == CHECK_CERT && engine != ENGINE_VI) strategy = WORKSPACE.get<t_idx>(WS_STRATEGY, mpg->get_n_0());
+	t_deadline deadline = CONF.timeout > 0 ? deadline_in(CONF.timeout) : NO_DEADLINE;
+	run.winner = engine;
+	mem_reset_peak_rss(); // else the peak RSS is the one of the whole benchmark so far
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if(engine == ENGINE_VI){
+		t_vi_conf conf = CONF.vi;
+		conf.deadline = deadline;
+		conf.stats = &run.stats;
+		conf.memory = &run.memory;
+		run.status = VI_compute_energy(mpg, energy, conf);
+	}else if(engine == ENGINE_KASI){
+		t_kasi_conf conf = CONF.kasi;
+		conf.deadline = deadline;
+		conf.strategy = strategy;
+		conf.stats = &run.stats;
+		conf.memory = &run.memory;
+		run.status = KASI_lowerWeakUpperBound(mpg, mpg->get_Top()+1, energy, conf);
+	}else{
+		t_portfolio_conf conf;
+		conf.vi = CONF.vi;
+		conf.kasi = CONF.kasi;
+		conf.vi.deadline = conf.kasi.deadline = deadline;
+		conf.kasi.strategy = strategy;
+		conf.vi.stats = conf.kasi.stats = &run.stats;
+		conf.vi.memory = conf.kasi.memory = &run.memory;
+		for(int e=0; e < PORTFOLIO_NUM_ENGINES; e++) conf.workspace[e] = &PORTFOLIO_WORKSPACE[e];
+		t_portfolio_result result = portfolio_compute_energy(mpg, energy, conf);
+		run.status = result.status;
+		run.winner = result.status == SOLVE_CONVERGED ? (result.winner == PORTFOLIO_VI ? ENGINE_VI : ENGINE_KASI) : -1;
+		if(run.winner != ENGINE_KASI) strategy = NULL;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	run.solve = seconds(start, end);
+	run.verified = -1;
+	run.verify = 0;
+	if(timed && CONF.check != CHECK_NONE && run.status == SOLVE_CONVERGED){
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		run.verified = check_energies(mpg, energy, strategy);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		run.verify = seconds(start, end);
+		if(!run.verified) FAILED = true;
+	}
+	run.finite = size - count(energy, energy + size, ULONG_MAX);
+	run.top = size - run.finite;
+	return run;
+}
+
+// nearest rank statistics of @sample
+t_stats get_stats(vector<double> sample){
+	t_stats s;
+	unsigned long n = sample.size();
+	sort(sample.begin(), sample.end());
+	s.min = sample[0];
+	s.max = sample[n-1];
+	s.median = n % 2 ? sample[n/2] : (sample[n/2-1] + sample[n/2]) / 2;
+	s.p90 = sample[(unsigned long) ceil(0.90 * n) - 1];
+	s.p99 = sample[(unsigned long) ceil(0.99 * n) - 1];
+	s.mean = 0;
+	for(unsigned long i=0; i < n; i++) s.mean += sample[i] / n;
+	return s;
+}
+
+double get_stat(const t_stats& s, int i){
+	const double values[] = {s.min, s.median, s.p90, s.p99, s.max, s.mean};
+	return values[i];
+}
+
+/*****************
+** output
+*****************/
+const char* winner_name(const t_run& run){
+	return run.winner >= 0 ? ENGINE_NAMES[run.winner] : "none";
+}
+
+const char* verified_name(const t_run& run){
+	return run.verified < 0 ? "skipped" : (run.verified ? "ok" : "failed");
+}
+
+// @s as a JSON string
+string json_string(const string& s){
+	string r = "\"";
+	for(unsigned long i=0; i < s.size(); i++){
+		if(s[i] == '"' || s[i] == '\\') r += '\\';
+		if((unsigned char) s[i] < 0x20){
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", s[i]);
+			r += buf;
+		}else r += s[i];
+	}
+	return r + "\"";
+}
+
+// @s as a CSV field
+string csv_string(const string& s){
+	if(s.find_first_of(",\"\n") == string::npos) return s;
+	string r = "\"";
+	for(unsigned long i=0; i < s.size(); i++){
+		if(s[i] == '"') r += '"';
+		r += s[i];
+	}
+	return r + "\"";
+}
+
+void print_text(ostream& out, const t_file_result& f){
+	out << f.file << ": n_0=" << f.n_0 << " n_1=" << f.n_1 << " m=" << f.m << " Top=" << f.Top << " weights [" << f.min_weight
+		<< ", " << f.max_weight << "] max_deg=" << f.max_deg << " load " << f.load << "s preprocess " << f.preprocess << "s" << endl;
+	for(unsigned long e=0; e < f.engines.size(); e++){
+		const vector<t_run>& runs = f.engines[e].runs;
+		vector<double> solve, verify;
+		unsigned long converged = 0, verified = 0;
+		for(unsigned long i=0; i < runs.size(); i++){
+			solve.push_back(runs[i].solve);
+			verify.push_back(runs[i].verify);
+			if(runs[i].status == SOLVE_CONVERGED) converged++;
+			if(runs[i].verified == 1) verified++;
+		}
+		t_stats s = get_stats(solve), v = get_stats(verify);
+		out << "  " << ENGINE_NAMES[f.engines[e].engine] << ": solve";
+		for(int i=0; i < 6; i++) out << " " << STAT_NAMES[i] << " " << get_stat(s, i) << "s";
+		out << ", verify median " << v.median << "s, " << converged << "/" << runs.size() << " converged, "
+			<< verified << "/" << runs.size() << " verified, " << runs.back().finite << " finite, " << runs.back().top << " top" << endl;
+		const t_mem_report& mem = runs.back().memory;
+		out << "    memory of the last run:";
+		for(int p=0; p < MEM_NUM_PARTS; p++) out << " " << mem_part_name((t_mem_part) p) << "=" << mem.bytes[p];
+		out << " total=" << mem.total() << " bytes, peak rss " << mem.peak_rss << " bytes" << endl;
+		if(SOLVER_STATS){
+			out << "    counters of the last run:";
+			for(int c=0; c < STAT_NUM_COUNTERS; c++)
+				if(runs.back().stats.counter[c] > 0) out << " " << stat_name((t_stat) c) << "=" << runs.back().stats.counter[c];
+			out << endl;
+		}
+	}
+}
+
+void print_csv(ostream& out, const t_file_result& f){
+	string prefix = csv_string(f.file) + "," + to_string(f.n_0) + "," + to_string(f.n_1) + "," + to_string(f.m) + "," + to_string(f.Top) + ","
+		+ to_string(f.min_weight) + "," + to_string(f.max_weight) + "," + to_string(f.max_deg) + ",";
+	for(unsigned long e=0; e < f.engines.size(); e++){
+		const vector<t_run>& runs = f.engines[e].runs;
+		const char* engine = ENGINE_NAMES[f.engines[e].engine];
+		vector<double> solve, verify;
+		for(unsigned long i=0; i < runs.size(); i++){
+			const t_run& r = runs[i];
+			out << prefix << engine << "," << i << "," << status_name(r.status) << "," << winner_name(r) << ","
+				<< f.load << "," << f.preprocess << "," << r.solve << "," << r.verify << "," << verified_name(r) << ","
+				<< r.finite << "," << r.top;
+			for(int p=0; p < MEM_NUM_PARTS; p++) out << "," << r.memory.bytes[p];
+			out << "," << r.memory.total() << "," << r.memory.peak_rss;
+			for(int c=0; SOLVER_STATS && c < STAT_NUM_COUNTERS; c++) out << "," << r.stats.counter[c];
+			out << endl;
+			solve.push_back(r.solve);
+			verify.push_back(r.verify);
+		}
+		t_stats s = get_stats(solve), v = get_stats(verify);
+		for(int i=0; i < 6; i++)
+			out << prefix << engine << "," << STAT_NAMES[i] << ",,," << f.load << "," << f.preprocess << ","
+				<< get_stat(s, i) << "," << get_stat(v, i) << ",,," << string(MEM_NUM_PARTS + 2, ',') << (SOLVER_STATS ? string(STAT_NUM_COUNTERS, ',') : "") << endl;
+	}
+}
+
+void print_json_stats(ostream& out, const t_stats& s){
+	out << "{";
+	for(int i=0; i < 6; i++) out << (i ? ", " : "") << "\"" << STAT_NAMES[i] << "\": " << get_stat(s, i);
+	out << "}";
+}
+
+void print_json(ostream& out, const t_file_result& f, bool first){
+	out << (first ? "" : ",\n") << "  {\"file\": " << json_string(f.file) << ", \"n_0\": " << f.n_0 << ", \"n_1\": " << f.n_1
+		<< ", \"m\": " << f.m << ", \"Top\": " << f.Top << ", \"min_weight\": " << f.min_weight << ", \"max_weight\": " << f.max_weight
+		<< ", \"max_deg\": " << f.max_deg << ", \"load_s\": " << f.load << ", \"preprocess_s\": " << f.preprocess << ", \"engines\": [";
+	for(unsigned long e=0; e < f.engines.size(); e++){
+		const vector<t_run>& runs = f.engines[e].runs;
+		vector<double> solve, verify;
+		out << (e ? "," : "") << "\n    {\"engine\": \"" << ENGINE_NAMES[f.engines[e].engine] << "\", \"runs\": [";
+		for(unsigned long i=0; i < runs.size(); i++){
+			const t_run& r = runs[i];
+			out << (i ? "," : "") << "\n      {\"status\": \"" << status_name(r.status) << "\", \"winner\": \"" << winner_name(r)
+				<< "\", \"solve_s\": " << r.solve << ", \"verify_s\": " << r.verify << ", \"verified\": \"" << verified_name(r)
+				<< "\", \"finite\": " << r.finite << ", \"top\": " << r.top << ", \"memory\": {";
+			for(int p=0; p < MEM_NUM_PARTS; p++) out << "\"" << mem_part_name((t_mem_part) p) << "\": " << r.memory.bytes[p] << ", ";
+			out << "\"total\": " << r.memory.total() << ", \"peak_rss\": " << r.memory.peak_rss << "}";
+			if(SOLVER_STATS){
+				out << ", \"counters\": {";
+				for(int c=0; c < STAT_NUM_COUNTERS; c++) out << (c ? ", " : "") << "\"" << stat_name((t_stat) c) << "\": " << r.stats.counter[c];
+				out << "}";
+			}
+			out << "}";
+			solve.push_back(r.solve);
+			verify.push_back(r.verify);
+		}
+		out << "],\n     \"solve_s\": ";
+		print_json_stats(out, get_stats(solve));
+		out << ", \"verify_s\": ";
+		print_json_stats(out, get_stats(verify));
+		out << "}";
+	}
+	out << "]}";
+}
+
+void print_energy(ostream& out, unsigned long *energy, MeanPayoffGame *mpg){
+	unsigned long size = mpg->get_n_0() + mpg->get_n_1();
+	out << "ENERGY e[v]:" << endl;
+	for(unsigned long v=0; v<size; v++){
+		string e_v = (energy[v] == ULONG_MAX) ? "T" : to_string(energy[v]);
+		out << "e[" << v << "]=" << e_v << "; ";
+	} out << endl;
+}
 
 /***********************
-** test procedure 
+** benchmark procedure 
 **********************/
 /*
- TEST : 
-  1. load an MPG G
-  2. compute G's energies with KASI algorithm
+ BENCHMARK of a game G: 
+  1. load G, and build the indexes read by the solvers
+  2. for each engine, solve G CONF.warmup times untimed, then CONF.reps times timed,
+     each timed run being validated apart
 */
-void test(){
-	MeanPayoffGame* mpg = new MeanPayoffGame(INPUT_FILE_MPG.c_str());
-	double tot_time=0, tot_time_squared=0, avg_time=0, std_dev=0, max_time=0, min_time=1000000;
-	double time;
-	for(unsigned int j=0; j < NUM_TESTS; j++){
-		time = start_algorithms(mpg);
-		cout << "instance #" << j << " : " << time << endl;
-		tot_time += time;
-		tot_time_squared += time*time;	
-		if(time > max_time) max_time = time;
-		if(time < min_time) min_time = time;
+void bench_file(const string& file, ostream& out, bool first){
+	struct timespec start, end;
+	t_file_result f;
+	f.file = file;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	MeanPayoffGame* mpg = new MeanPayoffGame(file.c_str());
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	f.load = seconds(start, end);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	mpg->share();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	f.preprocess = seconds(start, end);
+	f.n_0 = mpg->get_n_0();
+	f.n_1 = mpg->get_n_1();
+	f.m = mpg->get_e();
+	f.Top = mpg->get_Top();
+	f.min_weight = mpg->get_min_weight();
+	f.max_weight = mpg->get_max_weight();
+	f.max_deg = mpg->get_max_deg();
+	for(unsigned long e=0; e < CONF.engines.size(); e++){
+		t_engine_result r;
+		r.engine = CONF.engines[e];
+		for(unsigned int i=0; i < CONF.warmup; i++) run_engine(mpg, r.engine, false);
+		for(unsigned int i=0; i < CONF.reps; i++) r.runs.push_back(run_engine(mpg, r.engine, true));
+		f.engines.push_back(r);
+		if(CONF.print_energy && CONF.format == FORMAT_TEXT) 
+			print_energy(out, WORKSPACE.get<unsigned long>(WS_ENERGY, f.n_0 + f.n_1), mpg);
 	}
-	avg_time = tot_time / NUM_TESTS;	
-	std_dev = sqrt((tot_time_squared / NUM_TESTS) - avg_time*avg_time);
-	double semi_disp_max = (max_time - min_time) / 2;
-	double err_perc = (semi_disp_max / avg_time)*100;
-	cout << "max: " << max_time << "sec" << endl;
-	cout << "min: " << min_time << "sec" << endl;
-	cout << "avg: " << avg_time << "sec" << endl;
-	cout << "std_dev: " << std_dev << "sec" << endl;
-	cout << "semi_disp_max: " << semi_disp_max << " err_perc: " << err_perc << endl;
+	if(CONF.format == FORMAT_TEXT) print_text(out, f);
+	else if(CONF.format == FORMAT_CSV) print_csv(out, f);
+	else print_json(out, f, first);
 	delete mpg;
 }
 
@@ -137,4 +585,3 @@ timespec time_diff(timespec start, timespec end){
 	}
 	return temp;
 }
-
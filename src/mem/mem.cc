@@ -0,0 +1,44 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fstream>
+#include <string>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include "mem.h"
+
+using namespace std;
+
+/* VmHWM of /proc/self/status, which mem_reset_peak_rss() can reset, else the
+   max RSS of getrusage(), which cannot be reset */
+unsigned long mem_peak_rss(){
+	ifstream status("/proc/self/status");
+	string line;
+	while(getline(status, line)){
+		if(line.compare(0, 6, "VmHWM:") != 0) continue;
+		return strtoul(line.c_str() + 6, NULL, 10) * 1024; // in kB
+	}
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+	return (unsigned long) usage.ru_maxrss * 1024;
+}
+
+/* writing 5 to /proc/self/clear_refs resets VmHWM, since Linux 4.0 */
+bool mem_reset_peak_rss(){
+	ofstream clear_refs("/proc/self/clear_refs");
+	if(!clear_refs.is_open()) return false;
+	clear_refs << "5" << endl;
+	return !clear_refs.fail();
+}
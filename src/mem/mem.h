@@ -0,0 +1,84 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Memory footprint of a solve: the bytes held by the game and by the solver, by kind of
+*  storage, and the peak resident set size of the process. A solve given a t_mem_report
+*  raises each part of it to the bytes it held, so that a report shared by solves run
+*  one after another holds their largest footprint. The peak RSS is the high-water mark
+*  of the whole process, reset by mem_reset_peak_rss() before the solve to measure it.
+*****************************************************************************************/
+
+#ifndef MEM
+#define MEM
+
+enum t_mem_part{
+	MEM_ARCS=0, // arc storage of the game: CSR arrays or adjacency lists, and max_neg
+	MEM_REV, // reverse CSR index of the game
+	MEM_PROJ, // strategy projections, see MPGProj
+	MEM_ARRAYS, // per-vertex arrays of the solver: energies, keys, counts, flags
+	MEM_QUEUES, // worklists and priority queues, and the vertex lists of KASI
+	MEM_NUM_PARTS
+};
+
+inline const char* mem_part_name(t_mem_part part){
+	static const char* names[MEM_NUM_PARTS] = {"arcs", "rev", "proj", "arrays", "queues"};
+	return names[part];
+}
+
+struct t_mem_report{
+	unsigned long bytes[MEM_NUM_PARTS];
+	unsigned long peak_rss; // bytes, 0 if unknown
+
+	t_mem_report(){ clear(); }
+	void clear(){
+		for(int i=0; i < MEM_NUM_PARTS; i++) this->bytes[i] = 0;
+		this->peak_rss = 0;
+	}
+	unsigned long total() const{
+		unsigned long t = 0;
+		for(int i=0; i < MEM_NUM_PARTS; i++) t += this->bytes[i];
+		return t;
+	}
+	// footprint of solves run one after another: the max of each part
+	void peak(const t_mem_report& other){
+		for(int i=0; i < MEM_NUM_PARTS; i++)
+			if(other.bytes[i] > this->bytes[i]) this->bytes[i] = other.bytes[i];
+		if(other.peak_rss > this->peak_rss) this->peak_rss = other.peak_rss;
+	}
+	// footprint of solves running concurrently: the sum of each part, but for
+	// the parts of the game if @same_game, which the solves share
+	void add(const t_mem_report& other, bool same_game){
+		for(int i=0; i < MEM_NUM_PARTS; i++){
+			if(same_game && (i == MEM_ARCS || i == MEM_REV)) this->bytes[i] = other.bytes[i] > this->bytes[i] ? other.bytes[i] : this->bytes[i];
+			else this->bytes[i] += other.bytes[i];
+		}
+		if(other.peak_rss > this->peak_rss) this->peak_rss = other.peak_rss;
+	}
+};
+
+// high-water mark of the resident set size of the process in bytes, 0 if unknown
+unsigned long mem_peak_rss();
+// resets the high-water mark to the current RSS, returns false if the kernel does not support it
+bool mem_reset_peak_rss();
+
+// raises the report @report, if not NULL, to the footprint @local of a solve, with the current peak RSS
+inline void mem_report(t_mem_report* report, t_mem_report& local){
+	if(report == NULL) return;
+	local.peak_rss = mem_peak_rss();
+	report->peak(local);
+}
+
+#endif
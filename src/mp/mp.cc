@@ -0,0 +1,312 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <climits>
+#include <assert.h>
+#include "mp.h"
+
+using namespace std;
+
+typedef __int128 t_big;
+
+// a fraction num/denom, denom > 0, not necessarily in lowest terms
+struct t_frac{
+	t_big num, denom;
+};
+
+// a subgame whose vertices have values in [lo, hi]
+struct t_mp_task{
+	shared_ptr<MeanPayoffGame> game;
+	vector<t_idx> vertex; // the vertex of the input game of each vertex of @game
+	t_frac lo, hi;
+	t_frac at; // threshold of the energies @warm
+	vector<t_nrg> warm; // energies of @game below the ones of its threshold game at @at
+};
+
+// the state shared by the threads
+struct t_mp_pool{
+	mutex lock;
+	condition_variable wake;
+	vector<t_mp_task*> tasks;
+	unsigned long busy = 0; // tasks being solved
+	const char* error = NULL; // first error thrown by a solve
+	t_rational* value;
+	const t_mp_conf* conf;
+};
+
+static const char* MP_ENGINE_NAMES[MP_NUM_ENGINES] = {"kasi", "vi"};
+
+// floor(a/b), b > 0
+static t_big floor_div(t_big a, t_big b){
+	t_big q = a / b;
+	return (a % b != 0 && a < 0) ? q - 1 : q;
+}
+
+// sign of x - y
+static int compare(t_frac x, t_frac y){
+	t_big l = x.num * y.denom, r = y.num * x.denom;
+	return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+// the fractions @L <= @x <= @R of denominator <= @n closest to @x, by a descent of the
+// Stern-Brocot tree moving each bound by as many mediants as possible at once
+static void bracket(t_frac x, t_big n, t_frac& L, t_frac& R){
+	t_big fl = floor_div(x.num, x.denom);
+	L = {fl, 1};
+	R = {fl + 1, 1};
+	if(fl * x.denom == x.num){
+		R = L;
+		return;
+	}
+	while(L.denom + R.denom <= n){
+		t_frac m = {L.num + R.num, L.denom + R.denom};
+		int c = compare(m, x);
+		if(c == 0){
+			L = R = m;
+			return;
+		}
+		if(c < 0){ // L + k*R <= x
+			t_big k = min(floor_div(x.num * L.denom - L.num * x.denom, R.num * x.denom - x.num * R.denom), (n - L.denom) / R.denom);
+			L = {L.num + k * R.num, L.denom + k * R.denom};
+			if(compare(L, x) == 0){
+				R = L;
+				return;
+			}
+		}else{ // R + k*L >= x
+			t_big k = min(floor_div(R.num * x.denom - x.num * R.denom, x.num * L.denom - L.num * x.denom), (n - R.denom) / L.denom);
+			R = {R.num + k * L.num, R.denom + k * L.denom};
+			if(compare(R, x) == 0){
+				L = R;
+				return;
+			}
+		}
+	}
+}
+
+// the least fraction of denominator <= @n that is >= @x
+static t_frac ceil_frac(t_frac x, t_big n){
+	t_frac L, R;
+	bracket(x, n, L, R);
+	return R;
+}
+
+// the greatest fraction of denominator <= @n that is <= @x
+static t_frac floor_frac(t_frac x, t_big n){
+	t_frac L, R;
+	bracket(x, n, L, R);
+	return L;
+}
+
+// the greatest fraction of denominator <= @n below @x, which is itself of
+// denominator <= @n: two such fractions are more than 1/(2n^2) apart
+static t_frac pred_frac(t_frac x, t_big n){
+	return floor_frac({2 * n * n * x.num - 1, 2 * n * n * x.denom}, n);
+}
+
+// e*(@to.denom/@from.denom) rounded down, \top above @Top
+static t_nrg scale_energy(t_nrg e, t_frac from, t_frac to, t_nrg Top){
+	if(e == ULONG_MAX) return ULONG_MAX;
+	t_big scaled = (t_big) e * to.denom / from.denom;
+	return scaled > (t_big) Top ? ULONG_MAX : (t_nrg) scaled;
+}
+
+// the subgame of @mpg induced by the vertices @keep, with the arcs between them
+template<typename I, typename W>
+static MeanPayoffGame* subgame(MeanPayoffGame *mpg, const vector<bool>& keep){
+	const t_csr<I, W>* csr = mpg->get_csr<I, W>();
+	t_idx n_0 = mpg->get_n_0();
+	t_idx size = n_0 + mpg->get_n_1();
+	vector<t_idx> pos(size);
+	t_idx sub_n_0 = 0, sub_size = 0;
+	for(t_idx u=0; u < size; u++){
+		if(!keep[u]) continue;
+		if(u < n_0) sub_n_0++;
+		pos[u] = sub_size++;
+	}
+	MeanPayoffGame* sub = new MeanPayoffGame(sub_n_0, sub_size - sub_n_0);
+	for(t_idx u=0; u < size; u++){
+		if(!keep[u]) continue;
+		for(I a=csr->offset[u]; a < csr->offset[u+1]; a++){
+			if(!keep[csr->head[a]]) continue;
+			t_w_arc arc;
+			arc.arc_idx = 0;
+			arc.tail_idx = pos[u];
+			arc.head_idx = pos[csr->head[a]];
+			arc.weight = csr->weight[a];
+			sub->push_arc(pos[u], arc);
+		}
+	}
+	assert(sub->is_well_defined());
+	sub->freeze();
+	return sub;
+}
+
+// the child task of @task on the vertices @keep, with values in [@lo, @hi],
+// starting from the energies @warm at threshold @at, or from 0 if NULL
+static t_mp_task* child(t_mp_task* task, const vector<bool>& keep, unsigned long count, t_frac lo, t_frac hi,
+	t_frac at, const vector<t_nrg>* warm){
+	t_mp_task* c = new t_mp_task;
+	if(count == task->vertex.size()) c->game = task->game;
+	else if(task->game->get_width() == WIDTH_32) c->game.reset(subgame<uint32_t, int32_t>(task->game.get(), keep));
+	else c->game.reset(subgame<t_idx, t_weight>(task->game.get(), keep));
+	for(unsigned long u=0; u < task->vertex.size(); u++){
+		if(!keep[u]) continue;
+		c->vertex.push_back(task->vertex[u]);
+		c->warm.push_back(warm != NULL ? (*warm)[u] : 0);
+	}
+	c->lo = lo;
+	c->hi = hi;
+	c->at = at;
+	return c;
+}
+
+// solves the threshold game of @task and splits it, or assigns the values of its vertices
+static void solve_task(t_mp_pool* pool, t_mp_task* task, SolverWorkspace* ws, t_solve_stats* stats, t_mem_report* mem, vector<t_mp_task*>& children){
+	const t_mp_conf* conf = pool->conf;
+	unsigned long size = task->vertex.size();
+	// the values of the subgame have denominator <= size
+	t_frac lo = ceil_frac(task->lo, size), hi = floor_frac(task->hi, size);
+	assert(compare(lo, hi) <= 0);
+	if(compare(lo, hi) == 0){
+		for(unsigned long u=0; u < size; u++)
+			pool->value[task->vertex[u]] = {(long long) lo.num, (long long) lo.denom};
+		return;
+	}
+	// threshold above the middle: values >= q go to [q, hi], the others to [lo, pred(q)]
+	t_frac q = ceil_frac({lo.num * hi.denom + hi.num * lo.denom, 2 * lo.denom * hi.denom}, size);
+	MeanPayoffGame* game = new MeanPayoffGame(task->game.get(), (long) q.num, (long) q.denom);
+	vector<t_nrg> energy(size);
+	t_status status;
+	try{
+		if(conf->engine == MP_VI){
+			t_vi_conf c = conf->vi;
+			c.threads = 1;
+			c.workspace = ws;
+			c.stats = stats;
+			c.memory = mem;
+			c.warm_start = conf->warm_start;
+			if(c.warm_start){
+				for(unsigned long u=0; u < size; u++)
+					energy[u] = scale_energy(task->warm[u], task->at, q, game->get_Top());
+			}
+			status = VI_compute_energy(game, energy.data(), c);
+		}else{
+			t_kasi_conf c = conf->kasi;
+			c.threads = 1;
+			c.workspace = ws;
+			c.stats = stats;
+			c.memory = mem;
+			c.strategy = NULL;
+			status = KASI_lowerWeakUpperBound(game, game->get_Top()+1, energy.data(), c);
+		}
+	}catch(...){
+		delete game;
+		throw;
+	}
+	delete game;
+	if(status != SOLVE_CONVERGED) throw "mean payoff threshold solve stopped early";
+	// finite energy at q iff the value is >= q. The upper side drops arcs of Max only, into
+	// vertices of energy \top, so its energies are those at q and then grow. The lower side
+	// drops arcs of Min, which may lower its energies below the ones of @task
+	vector<bool> upper(size), lower(size);
+	unsigned long num_upper = 0;
+	for(unsigned long u=0; u < size; u++){
+		upper[u] = energy[u] != ULONG_MAX;
+		lower[u] = !upper[u];
+		if(upper[u]) num_upper++;
+	}
+	if(num_upper > 0) children.push_back(child(task, upper, num_upper, q, hi, q, &energy));
+	if(num_upper < size){
+		t_frac p = pred_frac(q, size);
+		if(num_upper > 0) children.push_back(child(task, lower, size - num_upper, lo, p, lo, NULL));
+		else children.push_back(child(task, lower, size, lo, p, task->at, &task->warm));
+	}
+}
+
+// main loop of a thread: solves tasks until none is left or being solved,
+// its counters and footprint are added to the reports of the options of the engine
+static void mp_worker(t_mp_pool* pool){
+	SolverWorkspace ws;
+	t_solve_stats stats;
+	t_mem_report mem; // the largest footprint of the solves of the thread
+	unique_lock<mutex> guard(pool->lock);
+	while(true){
+		pool->wake.wait(guard, [&]{ return !pool->tasks.empty() || pool->busy == 0 || pool->error != NULL; });
+		if(pool->tasks.empty() || pool->error != NULL) break;
+		t_mp_task* task = pool->tasks.back();
+		pool->tasks.pop_back();
+		pool->busy++;
+		guard.unlock();
+		vector<t_mp_task*> children;
+		const char* error = NULL;
+		try{
+			solve_task(pool, task, &ws, &stats, &mem, children);
+		}catch(const char* msg){
+			error = msg;
+		}
+		delete task;
+		guard.lock();
+		pool->busy--;
+		if(error != NULL && pool->error == NULL) pool->error = error;
+		pool->tasks.insert(pool->tasks.end(), children.begin(), children.end());
+		pool->wake.notify_all();
+	}
+	STAT_REPORT(pool->conf->engine == MP_VI ? pool->conf->vi.stats : pool->conf->kasi.stats, stats);
+	t_mem_report* report = pool->conf->engine == MP_VI ? pool->conf->vi.memory : pool->conf->kasi.memory;
+	if(report != NULL) report->add(mem, false); // the threads solve distinct subgames at the same time
+}
+
+// threshold search on intervals [lo, hi], from [min weight, max weight]
+void MP_compute_values(MeanPayoffGame *mpg, t_rational* value, const t_mp_conf& conf){
+	t_idx size = mpg->get_n_0() + mpg->get_n_1();
+	assert(mpg->is_well_defined());
+	t_mp_pool pool;
+	pool.value = value;
+	pool.conf = &conf;
+	t_mp_task* root = new t_mp_task;
+	root->game = shared_ptr<MeanPayoffGame>(mpg, [](MeanPayoffGame*){}); // owned by the caller
+	root->vertex.resize(size);
+	for(t_idx u=0; u < size; u++) root->vertex[u] = u;
+	root->lo = {mpg->get_min_weight(), 1};
+	root->hi = {mpg->get_max_weight(), 1};
+	root->at = root->lo;
+	root->warm.assign(size, 0); // every energy is 0 at the min weight
+	pool.tasks.push_back(root);
+	unsigned int num_threads = conf.threads > 0 ? conf.threads : thread::hardware_concurrency();
+	if(num_threads == 0) num_threads = 1;
+	vector<thread> threads;
+	for(unsigned int i=1; i < num_threads; i++) threads.push_back(thread(mp_worker, &pool));
+	mp_worker(&pool);
+	for(unsigned int i=0; i < threads.size(); i++) threads[i].join();
+	for(unsigned long i=0; i < pool.tasks.size(); i++) delete pool.tasks[i];
+	if(pool.error != NULL) throw pool.error;
+}
+
+t_mp_engine MP_engine_from_string(const char* name){
+	for(int e=0; e < MP_NUM_ENGINES; e++)
+		if(string(name) == MP_ENGINE_NAMES[e]) return (t_mp_engine) e;
+	throw "unknown mean payoff engine";
+}
+
+const char* MP_engine_name(t_mp_engine engine){
+	assert(engine < MP_NUM_ENGINES);
+	return MP_ENGINE_NAMES[engine];
+}
@@ -0,0 +1,56 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Optimal mean payoff values of an MPG, by threshold search over the energy solvers.
+*  The value of every vertex is a fraction a/b with 1 <= b <= n, and it is >= a/b iff the
+*  energy of the vertex is finite in the game with weights b*w - a. The vertices are
+*  split around the first such fraction above the middle of the interval known to hold
+*  their values, each side being a subgame with the same values, until the interval
+*  is a single fraction. The threshold games keep weights within n times the input ones.
+*****************************************************************************************/
+
+#ifndef MP
+#define MP
+
+#include "../mpg/mpg.h"
+#include "../VI/VI.h"
+#include "../kasi/kasi.h"
+
+// energy solvers of the threshold games
+enum t_mp_engine{
+	MP_KASI=0, // KASI, see kasi.h
+	MP_VI, // Value Iteration, see VI.h, pseudo-polynomial in the weights scaled by the thresholds
+	MP_NUM_ENGINES
+};
+
+// options of MP_compute_values
+struct t_mp_conf{
+	t_mp_engine engine = MP_KASI;
+	unsigned int threads = 1; // threshold games solved at once, 0 uses all the cores
+	bool warm_start = true; // VI starts from the energies of the last threshold below, scaled, instead of from 0
+	t_vi_conf vi; // options of the MP_VI solves, the threads and workspace are per threshold game
+	t_kasi_conf kasi; // options of the MP_KASI solves, the threads and workspace are per threshold game
+};
+
+// returns the engine named @name ("kasi", "vi")
+t_mp_engine MP_engine_from_string(const char* name);
+const char* MP_engine_name(t_mp_engine engine);
+
+// stores in @value the optimal mean payoff value of every vertex of @mpg, where
+// Max maximizes and Min minimizes the mean weight, values are in lowest terms
+void MP_compute_values(MeanPayoffGame *mpg, t_rational* value, const t_mp_conf& conf = t_mp_conf());
+
+#endif
@@ -19,15 +19,140 @@
 #include <sstream>
 #include <assert.h>
 #include <algorithm>
+#include <type_traits>
 #include "math.h"
 #include "mpg.h"
 
 using namespace std;
 
+/* CSR helpers, instantiated for both storage widths */
+
+/* appends the arcs out of @u to @l, at most @max_arcs of them */
+template<typename I, typename W>
+static void csr_get_arcs(const t_csr<I, W>& csr, unsigned long u, list<t_w_arc>& l, unsigned long max_arcs){
+	for(I a=csr.offset[u]; a < csr.offset[u+1] && max_arcs > 0; a++, max_arcs--){
+		t_w_arc arc;
+		arc.arc_idx = a;
+		arc.tail_idx = u;
+		arc.head_idx = csr.head[a];
+		arc.weight = csr.weight[a];
+		l.push_back(arc);
+	}
+}
+
+/* allocates @csr and fills it with the adjacency lists @arcs */
+template<typename I, typename W>
+static void csr_fill(t_csr<I, W>& csr, list<t_w_arc>* arcs, unsigned long size, unsigned long m){
+	csr.n = size;
+	csr.m = m;
+	csr.offset = new I[size+1];
+	csr.head = new I[m];
+	csr.weight = new W[m];
+	I a = 0;
+	for(unsigned long u=0; u < size; u++){
+		csr.offset[u] = a;
+		list<t_w_arc>::iterator it = arcs[u].begin();
+		for(it; it!=arcs[u].end(); it++){
+			csr.head[a] = it->head_idx;
+			csr.weight[a] = it->weight;
+			a++;
+		}
+	}
+	csr.offset[size] = a;
+	assert(a == m);
+}
+
+/* allocates @dst and fills it with the arcs of @src, weights w mapped to @denom*w - @num */
+template<typename I, typename W, typename I2, typename W2>
+static void csr_reweight(const t_csr<I, W>& src, t_csr<I2, W2>& dst, long num, long denom){
+	dst.n = src.n;
+	dst.m = src.m;
+	dst.offset = new I2[src.n+1];
+	dst.head = new I2[src.m];
+	dst.weight = new W2[src.m];
+	copy(src.offset, src.offset + src.n + 1, dst.offset);
+	copy(src.head, src.head + src.m, dst.head);
+	for(unsigned long a=0; a < src.m; a++){
+		long w;
+		if(__builtin_mul_overflow((long) src.weight[a], denom, &w) || __builtin_sub_overflow(w, num, &w) ||
+			w < numeric_limits<W2>::min() || w > numeric_limits<W2>::max())
+			throw "reweighted MPG weights overflow";
+		dst.weight[a] = w;
+	}
+}
+
+/* deletes @csr arrays from heap memory */
+template<typename I, typename W>
+static void csr_delete(t_csr<I, W>& csr){
+	delete [] csr.offset;
+	delete [] csr.head;
+	delete [] csr.weight;
+	csr.offset = NULL;
+	csr.head = NULL;
+	csr.weight = NULL;
+	csr.m = 0;
+}
+
+/* returns the max abs value of the negative weights out of @u */
+template<typename I, typename W>
+static t_nrg csr_max_neg(const t_csr<I, W>& csr, unsigned long u){
+	t_nrg max_v = 0;
+	for(I a=csr.offset[u]; a < csr.offset[u+1]; a++)
+		if(csr.weight[a]<0 && (t_nrg)(-(t_weight)csr.weight[a]) > max_v) 
+			max_v = -(t_weight)csr.weight[a];
+	return max_v;
+}
+
+/* builds the reverse index @rev of @csr by counting sort on heads,
+   the vertices below @n_0 are Min's */
+template<typename I, typename W>
+static void rev_build(const t_csr<I, W>& csr, t_rev_csr<I, W>& rev, unsigned long n_0){
+	unsigned long size = csr.n;
+	unsigned long m = csr.m;
+	rev.offset = new I[size+1];
+	rev.max_first = new I[size];
+	rev.tail = new I[m];
+	rev.arc = new I[m];
+	rev.weight = new W[m];
+	fill_n(rev.offset, size+1, 0);
+	for(I a=0; a < m; a++)
+		rev.offset[csr.head[a]+1]++;
+	for(unsigned long v=0; v < size; v++)
+		rev.offset[v+1] += rev.offset[v];
+	I* next = new I[size];
+	copy(rev.offset, rev.offset+size, next);
+	for(unsigned long u=0; u < size; u++){
+		if(u == n_0) copy(next, next+size, rev.max_first);
+		for(I a=csr.offset[u]; a < csr.offset[u+1]; a++){
+			I i = next[csr.head[a]]++;
+			rev.tail[i] = u;
+			rev.arc[i] = a;
+			rev.weight[i] = csr.weight[a];
+		}
+	}
+	if(n_0 == size) copy(next, next+size, rev.max_first);
+	delete [] next;
+}
+
+/* deletes @rev arrays from heap memory */
+template<typename I, typename W>
+static void rev_delete(t_rev_csr<I, W>& rev){
+	delete [] rev.offset;
+	delete [] rev.max_first;
+	delete [] rev.tail;
+	delete [] rev.arc;
+	delete [] rev.weight;
+}
+
 /*Constructor*/
 MeanPayoffGame::MeanPayoffGame(const char* filename){
+	if(is_bin_file(filename)){
+		load_bin(filename);
+		return;
+	}
 	load(filename);
 	assert(is_well_defined());
+	freeze();
 }
 
 /*Another Constructor*/
@@ -35,13 +160,88 @@ MeanPayoffGame::MeanPayoffGame(unsigned long n_0, unsigned long n_1){
 	assert(n_0 + n_1 > 0);
 	this->n_0 = n_0; // black nodes
 	this->n_1 = n_1; // black nodes
+	this->e = 0;
 	init_arcs();
 }
 
+/*Reweighting Constructor: a copy of @mpg whose arc weights w become @denom*w - @num,
+  the energies of the copy are finite where the mean payoff values of @mpg are >= num/denom*/
+MeanPayoffGame::MeanPayoffGame(MeanPayoffGame *mpg, long num, long denom){
+	assert(denom > 0);
+	this->n_0 = mpg->n_0;
+	this->n_1 = mpg->n_1;
+	this->e = mpg->e;
+	unsigned long size = this->n_0 + this->n_1;
+	init_frozen(WIDTH_64);
+	if(mpg->get_width() == WIDTH_32) csr_reweight(*mpg->get_csr<uint32_t, int32_t>(), this->csr64, num, denom);
+	else csr_reweight(*mpg->get_csr<t_idx, t_weight>(), this->csr64, num, denom);
+	init_info();
+	// the weights are an increasing map of the weights of @mpg
+	this->info.min_weight = mpg->get_min_weight() * denom - num;
+	this->info.max_weight = mpg->get_max_weight() * denom - num;
+	this->info.min_deg = mpg->get_min_deg();
+	this->info.max_deg = mpg->get_max_deg();
+	for(unsigned long u=0; u < size; u++){
+		this->info.max_neg[u] = csr_max_neg(this->csr64, u);
+		if(__builtin_add_overflow(this->info.Top, this->info.max_neg[u], &this->info.Top) || this->info.Top >= ULONG_MAX-1)
+			throw "reweighted MPG energies overflow";
+	}
+	if(select_width() == WIDTH_32){
+		csr_reweight(this->csr64, this->csr32, 0, 1);
+		csr_delete(this->csr64);
+		this->width = WIDTH_32;
+	}
+}
+
+/*CSR Constructor: a frozen game of the width of (I,W) that takes over the arrays of @csr,
+  allocated with new[], which is left empty. The heads must be below @n_0 + @n_1*/
+template<typename I, typename W>
+MeanPayoffGame::MeanPayoffGame(unsigned long n_0, unsigned long n_1, t_csr<I, W>& csr){
+	assert(n_0 + n_1 > 0 && csr.n == n_0 + n_1);
+	this->n_0 = n_0;
+	this->n_1 = n_1;
+	this->e = csr.m;
+	unsigned long size = n_0 + n_1;
+	init_frozen(is_same<I, uint32_t>::value ? WIDTH_32 : WIDTH_64);
+	init_info();
+	bool first = true;
+	this->info.min_deg = this->info.max_deg = csr.offset[1] - csr.offset[0];
+	for(unsigned long u=0; u < size; u++){
+		unsigned long deg = csr.offset[u+1] - csr.offset[u];
+		if(deg < this->info.min_deg) this->info.min_deg = deg;
+		if(deg > this->info.max_deg) this->info.max_deg = deg;
+		for(I a=csr.offset[u]; a < csr.offset[u+1]; a++){
+			if(first || csr.weight[a] < this->info.min_weight) this->info.min_weight = csr.weight[a];
+			if(first || csr.weight[a] > this->info.max_weight) this->info.max_weight = csr.weight[a];
+			first = false;
+		}
+		this->info.max_neg[u] = csr_max_neg(csr, u);
+		if(__builtin_add_overflow(this->info.Top, this->info.max_neg[u], &this->info.Top) || this->info.Top >= ULONG_MAX-1){
+			delete [] this->info.max_neg;
+			throw "MPG energies overflow";
+		}
+	}
+	if(this->width == WIDTH_32 && select_width() != WIDTH_32){
+		delete [] this->info.max_neg;
+		throw "MPG does not fit in 32-bit width";
+	}
+	if constexpr(is_same<I, uint32_t>::value) this->csr32 = csr;
+	else this->csr64 = csr;
+	csr.offset = csr.head = NULL;
+	csr.weight = NULL;
+	csr.m = 0;
+}
+
+template MeanPayoffGame::MeanPayoffGame(unsigned long n_0, unsigned long n_1, t_csr<uint32_t, int32_t>& csr);
+template MeanPayoffGame::MeanPayoffGame(unsigned long n_0, unsigned long n_1, t_csr<t_idx, t_weight>& csr);
+
 /*Destructor*/
 MeanPayoffGame::~MeanPayoffGame(){
 //	if(VERBOSE_MODE) o_stream << "Destroying MPG... ";
 	delete_arcs();
+	if(this->map_addr != NULL) this->info.max_neg = NULL; // lives in the mapping
+	delete_csr();
+	delete [] this->info.max_neg;
 //	if(VERBOSE_MODE) o_stream << "done!"<< endl;
 }
 
@@ -60,118 +260,144 @@ unsigned long MeanPayoffGame::get_e(){
 	return this->e;
 }
 
-/* computes and returns the max abs value of arc weights */
+/* returns the sum over all vertices of their max negative weight (abs value) */
 unsigned long MeanPayoffGame::get_Top(){
-	unsigned long Top=0;
-	unsigned long size = this->get_n_0() + this->get_n_1();
+	return this->info.Top;
+}
+
+/* returns the max abs value of the negative weights out of @u, 0 if none */
+t_nrg MeanPayoffGame::get_max_neg(unsigned long u){
+	return this->info.max_neg[u];
+}
+
+/* returns the min arc weight */
+t_weight MeanPayoffGame::get_min_weight(){
+	if(this->info.stale) refresh_info();
+	return this->info.min_weight;
+}
+
+/* returns the max arc weight */
+t_weight MeanPayoffGame::get_max_weight(){
+	if(this->info.stale) refresh_info();
+	return this->info.max_weight;
+}
+
+/* returns the min out-degree */
+unsigned long MeanPayoffGame::get_min_deg(){
+	if(this->info.stale) refresh_info();
+	return this->info.min_deg;
+}
+
+/* returns the max out-degree */
+unsigned long MeanPayoffGame::get_max_deg(){
+	if(this->info.stale) refresh_info();
+	return this->info.max_deg;
+}
+
+/* returns the out-degree of @u */
+unsigned long MeanPayoffGame::get_deg(unsigned long u){
+	if(this->frozen && this->width == WIDTH_32) return this->csr32.offset[u+1] - this->csr32.offset[u];
+	if(this->frozen) return this->csr64.offset[u+1] - this->csr64.offset[u];
+	return this->arcs[u].size();
+}
+
+/* initializes the metadata of a game with no arcs */
+void MeanPayoffGame::init_info(){
+	unsigned long size = this->n_0 + this->n_1;
+	this->info.Top = 0;
+	this->info.max_neg = new t_nrg[size];
+	fill_n(this->info.max_neg, size, 0);
+	this->info.min_weight = 0;
+	this->info.max_weight = 0;
+	this->info.min_deg = 0;
+	this->info.max_deg = 0;
+	this->info.stale = false;
+}
+
+/* recomputes max_neg[u] after the arcs out of @u changed, and updates Top */
+void MeanPayoffGame::update_info(unsigned long u){
+	t_nrg max_v = 0;
+	if(this->frozen){
+		max_v = this->width == WIDTH_32 ? csr_max_neg(this->csr32, u) : csr_max_neg(this->csr64, u);
+	}else{
+		list<t_w_arc>::iterator it = this->arcs[u].begin();
+		for(it; it!=this->arcs[u].end(); it++)
+			if(it->weight<0 && -it->weight > max_v) max_v = -it->weight;
+	}
+	this->info.Top = this->info.Top - this->info.max_neg[u] + max_v;
+	this->info.max_neg[u] = max_v;
+}
+
+/* recomputes the weight and degree ranges from scratch */
+void MeanPayoffGame::refresh_info(){
+	unsigned long size = this->n_0 + this->n_1;
+	bool first = true;
+	this->info.min_weight = this->info.max_weight = 0;
+	this->info.min_deg = this->info.max_deg = size > 0 ? get_deg(0) : 0;
 	for(unsigned long u=0; u < size; u++){
-		list<t_w_arc>* arcs = this->get_arcs(u);
-		list<t_w_arc>::iterator it = arcs->begin();
-		long max_v = 0;
-		for(it; it!=arcs->end(); it++){
-			t_w_arc arc = *it;
-			if(arc.weight<0 && -arc.weight > max_v) max_v = -arc.weight;
+		unsigned long deg = get_deg(u);
+		if(deg < this->info.min_deg) this->info.min_deg = deg;
+		if(deg > this->info.max_deg) this->info.max_deg = deg;
+		list<t_w_arc> tmp;
+		list<t_w_arc>* arc_list = &tmp;
+		if(this->frozen && this->width == WIDTH_32) csr_get_arcs(this->csr32, u, tmp, deg);
+		else if(this->frozen) csr_get_arcs(this->csr64, u, tmp, deg);
+		else arc_list = &this->arcs[u];
+		list<t_w_arc>::iterator it = arc_list->begin();
+		for(it; it!=arc_list->end(); it++){
+			if(first || it->weight < this->info.min_weight) this->info.min_weight = it->weight;
+			if(first || it->weight > this->info.max_weight) this->info.max_weight = it->weight;
+			first = false;
 		}
-		Top += max_v;
 	}
-	return Top;
+	this->info.stale = false;
 }
 
-/* returns arc list for tail index @tail_idx */
+/* returns arc list for tail index @tail_idx, 
+   a frozen game is turned back into adjacency lists first */
 list<t_w_arc>* MeanPayoffGame::get_arcs(unsigned long tail_idx){
+	if(this->frozen) thaw();
 	return &this->arcs[tail_idx];
 }
 
 /* sets arcs @arc_list for tail @u */
 void MeanPayoffGame::set_arcs(unsigned long u, list<t_w_arc>* arc_list){
 	assert(arc_list->size()>0);
+	if(this->frozen) thaw();
 	this->e -= this->arcs[u].size();
 	this->arcs[u] = *arc_list;
 	this->e += this->arcs[u].size();
-}
-
-/**
-* Initializes @this MPG by loading the input file @filename
-* see "dat/mpg.dat" for an MPG file format example.
-**/
-void MeanPayoffGame::load(const char* filename){
-	/*
-	* init_steps:
-	*	0: read number of vertices
-	*	1: read number of arcs 
-	* 	2: read arcs  
-	*/
-	long init_step = 0;
-	/**/
-//	if(VERBOSE_MODE) o_stream << endl << "Verbose mode on"<<endl; else o_stream << endl <<"Verbose mode off"<<endl;
-//	if(VERBOSE_MODE) o_stream << "Loading Mean Payoff Game from input file: " << filename << "..." << endl;
-	ifstream input(filename);
-	string line;
-	unsigned long arc_counter = 0;
-	if(input.is_open()){
-		unsigned long long num_line = 0;
-		long num_white, num_black, num_arcs;
-		while(getline(input, line)){
-			num_line++;
-			if(line.compare(0,1,"#")==0){ // skip comments
-//				if(VERBOSE_MODE) o_stream << "   ... comment found at line #" << num_line << endl;
-				continue;
-			}
-			istringstream iss(line);
-			switch(init_step){
-				case 0:
-//					if(VERBOSE_MODE) o_stream 
-//						<< "   ... reading vertex number at line #" << num_line;
-					iss >> num_black >> num_white;
-					assert(num_black >= 0);
-					assert(num_white >= 0);
-					this->n_0 = num_black;
-					this->n_1 = num_white;
-					init_arcs();
-					init_step++;
-//					if(VERBOSE_MODE) o_stream << ": black vertices " << num_black 
-//							<< "; white vertices " << num_white << endl;
-				break;
-				case 1:
-//					if(VERBOSE_MODE) o_stream 
-//						<< "   ... reading arcs number at line #" << num_line;
-					iss >> num_arcs;
-					assert(num_arcs >= 0);
-					init_step++;
-//					if(VERBOSE_MODE) o_stream << ": number of arcs " << num_arcs << endl;
-				break;
-				case 2:
-//					if(VERBOSE_MODE) o_stream << "   ... reading arc data at line #" << num_line;
-					assert(arc_counter < num_arcs);
-					long tail, head;
-					long weight;
-					iss >> tail >> head >> weight; // assume indexes are absolute 
-					assert(tail >= 0 && tail < this->n_0 + this->n_1);
-					assert(head >= 0 && head < this->n_0 + this->n_1);
-					//assert(head != tail); // we assume no self loop  
-					t_w_arc new_arc;
-					new_arc.arc_idx = arc_counter;
-					new_arc.tail_idx = tail;
-					new_arc.head_idx = head;
-					new_arc.weight = weight;
-					push_arc(tail, new_arc);
-					arc_counter++;
-//					if(VERBOSE_MODE) o_stream << ": tail " << tail 
-//					     << " head " << head 
-//					     <<" weight " << weight << endl;
-				break;
-			}
-		}
-		input.close();
-	}else throw "cannot open input file";
-//	if(VERBOSE_MODE) o_stream << "... Mean Payoff Game load completed!" << endl<<endl;
+	update_info(u);
+	this->info.stale = true;
 }
 
 /* initializes arcs array list */
 void MeanPayoffGame::init_arcs(){
 	unsigned long size = this->n_0 + this->n_1;
+	init_frozen(WIDTH_64);
 	this->arcs = new list<t_w_arc>[size];
-	this->e=0;
+	this->frozen = false;
+	init_info();
+}
+
+/* initializes @this as a frozen game of width @width with e arcs, 
+   the CSR arrays and the metadata are left to the caller */
+void MeanPayoffGame::init_frozen(t_width width){
+	unsigned long size = this->n_0 + this->n_1;
+	this->arcs = NULL;
+	this->frozen = true;
+	this->width = width;
+	this->csr32.n = this->csr64.n = size;
+	this->csr32.m = this->csr64.m = this->e;
+	this->csr32.offset = NULL;
+	this->csr32.head = NULL;
+	this->csr32.weight = NULL;
+	this->csr64.offset = NULL;
+	this->csr64.head = NULL;
+	this->csr64.weight = NULL;
+	this->rev_built = false;
+	this->map_addr = NULL;
+	this->map_len = 0;
 }
 
 /* pushes #arc into tail with index tail_idx*/
@@ -179,11 +405,112 @@ void MeanPayoffGame::push_arc(unsigned long tail_idx, t_w_arc arc){
 	assert(tail_idx < this->n_0 + this->n_1);
 	get_arcs(tail_idx)->push_back(arc);
 	this->e++;
+	// update metadata in O(1)
+	if(arc.weight < 0 && -arc.weight > this->info.max_neg[tail_idx]){
+		this->info.Top += -arc.weight - this->info.max_neg[tail_idx];
+		this->info.max_neg[tail_idx] = -arc.weight;
+	}
+	if(this->e == 1 || arc.weight < this->info.min_weight) this->info.min_weight = arc.weight;
+	if(this->e == 1 || arc.weight > this->info.max_weight) this->info.max_weight = arc.weight;
+	unsigned long deg = this->arcs[tail_idx].size();
+	if(deg > this->info.max_deg) this->info.max_deg = deg;
+	if(deg-1 == this->info.min_deg) this->info.stale = true; // min_deg may grow
 }
 
 /* deletes arcs from heap memory*/
 void MeanPayoffGame::delete_arcs(){
 	delete [] this->arcs;
+	this->arcs = NULL;
+}
+
+/* deletes CSR arrays from heap memory*/
+void MeanPayoffGame::delete_csr(){
+	delete_rev();
+	if(this->map_addr != NULL) unmap();
+	csr_delete(this->csr32);
+	csr_delete(this->csr64);
+}
+
+/* deletes the reverse CSR index from heap memory*/
+void MeanPayoffGame::delete_rev(){
+	if(!this->rev_built) return;
+	if(this->width == WIDTH_32) rev_delete(this->rev32);
+	else rev_delete(this->rev64);
+	this->rev_built = false;
+}
+
+/* builds the reverse CSR index of the frozen game */
+void MeanPayoffGame::build_rev(){
+	assert(this->frozen);
+	if(this->width == WIDTH_32) rev_build(this->csr32, this->rev32, this->n_0);
+	else rev_build(this->csr64, this->rev64, this->n_0);
+	this->rev_built = true;
+}
+
+/* returns the narrowest width able to store @this, see mpg_select_width() */
+t_width MeanPayoffGame::select_width(){
+	return mpg_select_width(this->n_0 + this->n_1, this->e, get_min_weight(), get_max_weight(), this->info.Top);
+}
+
+/* compacts the adjacency lists into the CSR arrays of width @width and releases 
+   the lists, arcs keep their list order, so the i-th arc of u gets index offset[u]+i */
+void MeanPayoffGame::freeze(t_width width){
+	if(this->frozen && (width == WIDTH_AUTO || width == this->width)) return;
+	if(this->frozen) thaw();
+	if(width == WIDTH_AUTO) width = select_width();
+	if(width == WIDTH_32 && select_width() != WIDTH_32) throw "MPG does not fit in 32-bit width";
+	unsigned long size = this->n_0 + this->n_1;
+	if(width == WIDTH_32) csr_fill(this->csr32, this->arcs, size, this->e);
+	else csr_fill(this->csr64, this->arcs, size, this->e);
+	delete_arcs();
+	this->width = width;
+	this->frozen = true;
+}
+
+/* turns the CSR arrays back into adjacency lists, so that @this can be modified */
+void MeanPayoffGame::thaw(){
+	if(!this->frozen) return;
+	unsigned long size = this->n_0 + this->n_1;
+	this->arcs = new list<t_w_arc>[size];
+	for(unsigned long u=0; u < size; u++){
+		if(this->width == WIDTH_32) csr_get_arcs(this->csr32, u, this->arcs[u], ULONG_MAX);
+		else csr_get_arcs(this->csr64, u, this->arcs[u], ULONG_MAX);
+	}
+	delete_csr();
+	this->frozen = false;
+}
+
+/* returns true iff the arcs of @this are stored in CSR form */
+bool MeanPayoffGame::is_frozen(){
+	return this->frozen;
+}
+
+/* returns the width of the CSR arc storage */
+t_width MeanPayoffGame::get_width(){
+	if(!this->frozen) freeze();
+	return this->width;
+}
+
+/* freezes @this and builds its reverse index and metadata, so that solvers
+   running on several threads only read it */
+void MeanPayoffGame::share(){
+	if(!this->frozen) freeze();
+	if(!this->rev_built) build_rev();
+	if(this->info.stale) refresh_info();
+}
+
+/* bytes of the arcs and of the reverse index, at the width they are stored with,
+   the arrays of a mapped binary file are counted as well */
+void MeanPayoffGame::memory(t_mem_report* report){
+	unsigned long size = this->n_0 + this->n_1;
+	unsigned long idx = this->width == WIDTH_32 ? sizeof(uint32_t) : sizeof(t_idx);
+	unsigned long wgt = this->width == WIDTH_32 ? sizeof(int32_t) : sizeof(t_weight);
+	report->bytes[MEM_ARCS] = size * sizeof(t_nrg); // max_neg
+	if(this->frozen) report->bytes[MEM_ARCS] += (size + 1) * idx + this->e * (idx + wgt);
+	else // list nodes hold an arc and two links
+		report->bytes[MEM_ARCS] += size * sizeof(list<t_w_arc>) + this->e * (sizeof(t_w_arc) + 2 * sizeof(void*));
+	// offset, max_first, and tail, arc, weight of the in-arcs
+	report->bytes[MEM_REV] = this->rev_built ? (2 * size + 1) * idx + this->e * (2 * idx + wgt) : 0;
 }
 
 /* checks whether @this is not empty and 
@@ -191,7 +518,7 @@ every vertex has at least one outgoing neighbour */
 bool MeanPayoffGame::is_well_defined(){
 	if(this->n_0 + this->n_1 == 0) return false; // do not consider empty games
 	for(unsigned long i=0; i < this->n_0 + this->n_1; i++)
-		if(get_arcs(i)->empty()) return false;
+		if(get_deg(i) == 0) return false;
 	return true; 	
 }
 
@@ -199,6 +526,8 @@ bool MeanPayoffGame::is_well_defined(){
 void MeanPayoffGame::remove_arc(unsigned long u){
 	get_arcs(u)->pop_front();
 	this->e--;
+	update_info(u);
+	this->info.stale = true;
 }
 
 /* prints to output */
@@ -207,7 +536,11 @@ void MeanPayoffGame::print(){
 	o_stream << this->n_0 << " " << this->n_1 << endl;
 	o_stream << this->e << endl;
 	for(unsigned long i=0; i < this->n_0 + this->n_1; i++){
-		list<t_w_arc>* arc_list = get_arcs(i);
+		list<t_w_arc> tmp;
+		list<t_w_arc>* arc_list = &tmp;
+		if(this->frozen && this->width == WIDTH_32) csr_get_arcs(this->csr32, i, tmp, ULONG_MAX);
+		else if(this->frozen) csr_get_arcs(this->csr64, i, tmp, ULONG_MAX);
+		else arc_list = &this->arcs[i];
 		list<t_w_arc>::iterator it = arc_list->begin();
 		for (it; it != arc_list->end(); it++){
 			t_w_arc arc = *it;
@@ -221,56 +554,74 @@ bool rational_equals(t_rational x, t_rational y){
 	return x.num*y.denom == x.denom*y.num;
 }
 
-//Initialize an arbitrary strategy for Player-"pl" in MPG "mpg" 
+/* returns the first arc out of @u */
+template<typename I, typename W>
+static t_w_arc csr_first_arc(const t_csr<I, W>& csr, unsigned long u){
+	assert(csr.offset[u] < csr.offset[u+1]);
+	t_w_arc arc;
+	arc.arc_idx = csr.offset[u];
+	arc.tail_idx = u;
+	arc.head_idx = csr.head[arc.arc_idx];
+	arc.weight = csr.weight[arc.arc_idx];
+	return arc;
+}
+
 MPGProj::MPGProj(MeanPayoffGame *mpg){
 	this->size = mpg->get_n_0() + mpg->get_n_1();	
-	this->arcs = new list<t_w_arc>[size];
+	this->chosen = new t_w_arc[this->size];
+	this->first = new unsigned long[this->size];
+	this->next = new unsigned long[this->size];
+	this->prev = new unsigned long[this->size];
 }
 
+//Initialize an arbitrary strategy for Player-"player" in MPG "mpg": the first arc of each of its vertices
 void MPGProj::init_arbitrary(MeanPayoffGame *mpg, bool player){ 
-	if(player){ // Max Strategy
-		for(unsigned long u=0; u < this->size; u++){
-			list<t_w_arc>* _arcs = mpg->get_arcs(u);
-			if(u < mpg->get_n_0())
-				this->arcs[u] = *_arcs;	
-			else{
-				t_w_arc arc = _arcs->front();
-				this->arcs[u] = list<t_w_arc>(1,arc);
-			}
-		}
-	}else{ // Min Strategy
-		for(unsigned long u=0; u < this->size; u++){
-			list<t_w_arc>* _arcs = mpg->get_arcs(u);
-			if(u >= mpg->get_n_0())
-				this->arcs[u] = *_arcs;	
-			else{
-				t_w_arc arc = _arcs->front();
-				this->arcs[u] = list<t_w_arc>(1,arc);
-			}
-		}
-	}
-}
-
-void MPGProj::init_reverse(MPGProj *pi){
+	fill_n(this->first, this->size, NONE);
 	for(unsigned long u=0; u < this->size; u++){
-		list<t_w_arc>* arcs_pi = pi->get_arcs(u); // u is tail
-		list<t_w_arc>::iterator it = arcs_pi->begin();
-		for(it; it!=arcs_pi->end(); it++){
-			t_w_arc c_arc = *it;
-			list<t_w_arc>* in_head_arcs = this->get_arcs(c_arc.head_idx);
-			in_head_arcs->push_front(c_arc);
+		bool owned = player ? u >= mpg->get_n_0() : u < mpg->get_n_0();
+		if(!owned){
+			this->chosen[u].arc_idx = NONE;
+			continue;
 		}
+		if(mpg->get_width() == WIDTH_32) this->chosen[u] = csr_first_arc(*mpg->get_csr<uint32_t, int32_t>(), u);
+		else this->chosen[u] = csr_first_arc(*mpg->get_csr<t_idx, t_weight>(), u);
+		link(u);
 	}
 }
 
 MPGProj::~MPGProj(){
-	delete [] this->arcs;
+	delete [] this->chosen;
+	delete [] this->first;
+	delete [] this->next;
+	delete [] this->prev;
 }
 
-list<t_w_arc>* MPGProj::get_arcs(unsigned long u){
-	return &this->arcs[u];
+unsigned long MPGProj::footprint(){
+	return this->size * (sizeof(t_w_arc) + 3 * sizeof(unsigned long));
 }
 
+// switches the arc chosen by the vertex @u of the player to @arc
 void MPGProj::set_arc(unsigned long u, t_w_arc arc){
-	this->arcs[u] = list<t_w_arc>(1,arc);
+	assert(this->chosen[u].arc_idx != NONE && arc.tail_idx == u);
+	if(arc.head_idx != this->chosen[u].head_idx){
+		unlink(u);
+		this->chosen[u] = arc;
+		link(u);
+	}else this->chosen[u] = arc;
+}
+
+// inserts @u in the list of its chosen head
+void MPGProj::link(unsigned long u){
+	unsigned long head = this->chosen[u].head_idx;
+	this->prev[u] = NONE;
+	this->next[u] = this->first[head];
+	if(this->first[head] != NONE) this->prev[this->first[head]] = u;
+	this->first[head] = u;
+}
+
+// removes @u from the list of its chosen head
+void MPGProj::unlink(unsigned long u){
+	if(this->prev[u] != NONE) this->next[this->prev[u]] = this->next[u];
+	else this->first[this->chosen[u].head_idx] = this->next[u];
+	if(this->next[u] != NONE) this->prev[this->next[u]] = this->prev[u];
 }
@@ -17,7 +17,10 @@
 #define MPG 
 
 #include <list>
+#include <limits>
+#include <stdint.h>
 #include "../conf.h"
+#include "../mem/mem.h"
 
 #define MAX 1 // player-1 is MAX
 #define MIN 0 // player-0 is MIN
@@ -27,6 +30,29 @@
 typedef unsigned long t_nrg, t_idx;
 typedef long t_weight;
 
+/* storage widths of a frozen MPG: 32-bit indexes and weights (uint32_t/int32_t) 
+   or 64-bit ones (t_idx/t_weight), WIDTH_AUTO picks the narrowest that fits */
+enum t_width{
+	WIDTH_AUTO = 0,
+	WIDTH_32 = 32,
+	WIDTH_64 = 64
+};
+
+/* returns the narrowest width able to store a game of @n vertices and @m arcs, with weights
+   in [@min_weight, @max_weight] and Top at most @Top: indexes up to n and m, weights, and
+   energies up to Top+1 with \top as max value */
+inline t_width mpg_select_width(unsigned long n, unsigned long m, t_weight min_weight, t_weight max_weight, unsigned long Top){
+	if(n < UINT32_MAX && m < UINT32_MAX && Top < UINT32_MAX-1 && min_weight >= INT32_MIN && max_weight <= INT32_MAX)
+		return WIDTH_32;
+	return WIDTH_64;
+}
+
+/* bound n*max_weight on the Top of a game of @n vertices with weights in [-@max_weight, @max_weight],
+   ULONG_MAX if it overflows */
+inline unsigned long mpg_top_bound(unsigned long n, t_weight max_weight){
+	unsigned long Top;
+	return __builtin_mul_overflow(n, (unsigned long) max_weight, &Top) ? ULONG_MAX : Top;
+}
 
 /* MPG weighted arc data type definition */
 struct t_w_arc{
@@ -51,6 +77,102 @@ struct t_graph{
 	std::list<t_w_arc>* arcs;
 };
 
+/* MPG compressed-sparse-row arc storage: the out-arcs of vertex u are
+   stored at positions offset[u] to offset[u+1]-1 of head[] and weight[],
+   the position of an arc in these arrays is its arc index.
+   I is the (unsigned) index type, W is the (signed) weight type */
+template<typename I, typename W>
+struct t_csr{
+	unsigned long n; // number of vertices
+	unsigned long m; // number of arcs
+	I* offset; // n+1 entries
+	I* head; // m entries
+	W* weight; // m entries
+};
+
+/* MPG reverse CSR index: the in-arcs of vertex v are stored at positions 
+   offset[v] to offset[v+1]-1 of tail[], arc[] and weight[], ordered by tail, 
+   arc[] maps each in-arc to its arc index in the forward t_csr storage */
+template<typename I, typename W>
+struct t_rev_csr{
+	I* offset; // n+1 entries
+	I* max_first; // n entries, position of the first in-arc of v whose tail is Max's
+	I* tail; // m entries
+	I* arc; // m entries
+	W* weight; // m entries
+};
+
+/* computes the circle-minus operator e (-) w = max(0, e-w), see [Brim2011],
+   the max value of I stands for \top, values above Top saturate to \top */
+template<typename I, typename W>
+inline I circle_op(t_nrg Top, I e, W w){
+	const I top = std::numeric_limits<I>::max();
+	if(e == top) return top;
+	uint64_t x = e;
+	if(w < 0){ // e - w may not fit in 64 bits when Top does
+		if(__builtin_add_overflow(x, 0 - (uint64_t)(int64_t)w, &x)) return top;
+	}else if(x > (uint64_t)w) x -= (uint64_t)w;
+	else return 0;
+	return x > Top ? top : (I)x;
+}
+
+/* copies the energies @src of width I into @dst, mapping \top to ULONG_MAX */
+template<typename I>
+inline void widen_energy(const I* src, t_nrg* dst, unsigned long size){
+	const I top = std::numeric_limits<I>::max();
+	for(unsigned long u=0; u < size; u++)
+		dst[u] = src[u] == top ? ULONG_MAX : (t_nrg)src[u];
+}
+
+/* copies the energies @src into @dst of width I, mapping ULONG_MAX to \top */
+template<typename I>
+inline void narrow_energy(const t_nrg* src, I* dst, unsigned long size){
+	const I top = std::numeric_limits<I>::max();
+	for(unsigned long u=0; u < size; u++)
+		dst[u] = src[u] >= (t_nrg)top ? top : (I)src[u];
+}
+
+/* MPG metadata, kept up to date while arcs are pushed, set or removed */
+struct t_mpg_info{
+	unsigned long Top; // sum over all vertices of their max negative weight
+	t_nrg* max_neg; // max abs value of the negative weights out of each vertex 
+	t_weight min_weight; // min arc weight
+	t_weight max_weight; // max arc weight
+	unsigned long min_deg; // min out-degree
+	unsigned long max_deg; // max out-degree
+	bool stale; // weight and degree ranges must be recomputed
+};
+
+#define MPG_BIN_MAGIC "MPGBIN\n" // magic string of binary MPG files, 8 bytes with '\0'
+#define MPG_BIN_VERSION 1 // version of the binary MPG file format
+#define MPG_BIN_ALIGN 64 // alignment of the sections of binary MPG files
+
+/* header of the binary MPG file format, it is followed by the CSR sections
+   offset[n+1] and head[m] of width-bit unsigned indexes, weight[m] of width-bit
+   signed weights and max_neg[n] of 64-bit energies, each section starting at 
+   the byte position given in the header. Integers are stored in host byte order,
+   so that the sections can be mmap'ed and used as they are */
+struct t_mpg_bin_header{
+	char magic[8]; // MPG_BIN_MAGIC
+	uint32_t version; // MPG_BIN_VERSION
+	uint32_t width; // 32 or 64
+	uint64_t n_0; // number of Min vertices
+	uint64_t n_1; // number of Max vertices
+	uint64_t m; // number of arcs
+	uint64_t Top; // see MeanPayoffGame::get_Top()
+	int64_t min_weight; // min arc weight
+	int64_t max_weight; // max arc weight
+	uint64_t min_deg; // min out-degree
+	uint64_t max_deg; // max out-degree
+	uint64_t offset_pos; // byte position of the offset[] section
+	uint64_t head_pos; // byte position of the head[] section
+	uint64_t weight_pos; // byte position of the weight[] section
+	uint64_t max_neg_pos; // byte position of the max_neg[] section
+	uint64_t file_size; // total size of the file in bytes
+};
+
+void mpg_bin_layout(t_mpg_bin_header* h);
+
 /* MPG data type definition */
 class MeanPayoffGame{
 	private:
@@ -59,16 +181,44 @@ class MeanPayoffGame{
 	unsigned long e; // number of arcs
 	// we assume that Black=MIN nodes are numbered 0 to n_0-1
 	// and that White=MAX nodes are numbered n_0 to n_0 + n_1 - 1
-	std::list<t_w_arc>* arcs; // array of post adjacency lists  
+	// the arcs are kept in post adjacency lists while the game is being 
+	// built, then frozen into the CSR arrays used by the solvers, 
+	// only the CSR arrays of the chosen width are allocated
+	std::list<t_w_arc>* arcs; // array of post adjacency lists, NULL if frozen
+	t_csr<uint32_t, int32_t> csr32; // 32-bit CSR arc storage
+	t_csr<t_idx, t_weight> csr64; // 64-bit CSR arc storage
+	bool frozen;
+	t_width width; // width of the CSR arc storage, valid only if frozen
+	t_rev_csr<uint32_t, int32_t> rev32; // reverse CSR indexes, built on demand
+	t_rev_csr<t_idx, t_weight> rev64;
+	bool rev_built;
+	t_mpg_info info; // metadata
+	void* map_addr; // mmap'ed binary file holding the CSR arrays, NULL if none
+	unsigned long map_len; // length of the mapping
 		
 	void load(const char* f);
+	template<typename I> void load_arcs(const char* p, const char* end, unsigned long m);
+	void load_bin(const char* f);
+	void unmap();
 	void init_arcs();
+	void init_frozen(t_width width);
 	void delete_arcs();
+	void delete_csr();
+	void delete_rev();
+	void build_rev();
+	void thaw();
+	void init_info();
+	void update_info(unsigned long u);
+	void refresh_info();
+	unsigned long get_deg(unsigned long u);
+	t_width select_width();
 
 	public:
 	// constructor/destructor
 	MeanPayoffGame(const char* f);
 	MeanPayoffGame(unsigned long n_0, unsigned long n_1);
+	MeanPayoffGame(MeanPayoffGame *mpg, long num, long denom);
+	template<typename I, typename W> MeanPayoffGame(unsigned long n_0, unsigned long n_1, t_csr<I, W>& csr);
 	~MeanPayoffGame();
 
 	//internal state methods
@@ -80,22 +230,80 @@ class MeanPayoffGame{
 	unsigned long get_e();
 	void remove_arc(unsigned long u);
 	unsigned long get_Top();	
+	t_nrg get_max_neg(unsigned long u);
+	t_weight get_min_weight();
+	t_weight get_max_weight();
+	unsigned long get_min_deg();
+	unsigned long get_max_deg();
 	bool is_well_defined();
 	void print();	
+	void save_bin(const char* f);
+	static bool is_bin_file(const char* f);
+
+	//CSR storage methods
+	void freeze(t_width width = WIDTH_AUTO);
+	bool is_frozen();
+	t_width get_width();
+	void share();
+	template<typename I, typename W> const t_csr<I, W>* get_csr();
+	template<typename I, typename W> const t_rev_csr<I, W>* get_rev_csr();
+	void memory(t_mem_report* report); // sets the bytes of the arc storage and of the reverse index
 };
 
+/* returns the 32-bit CSR arc storage, freezing @this first if needed */
+template<> inline const t_csr<uint32_t, int32_t>* MeanPayoffGame::get_csr<uint32_t, int32_t>(){
+	if(!this->frozen) freeze();
+	if(this->width != WIDTH_32) throw "MPG arcs are not stored with 32-bit width";
+	return &this->csr32;
+}
+
+/* returns the 64-bit CSR arc storage, freezing @this first if needed */
+template<> inline const t_csr<t_idx, t_weight>* MeanPayoffGame::get_csr<t_idx, t_weight>(){
+	if(!this->frozen) freeze();
+	if(this->width != WIDTH_64) throw "MPG arcs are not stored with 64-bit width";
+	return &this->csr64;
+}
+
+/* returns the 32-bit reverse CSR index, building it on first use */
+template<> inline const t_rev_csr<uint32_t, int32_t>* MeanPayoffGame::get_rev_csr<uint32_t, int32_t>(){
+	get_csr<uint32_t, int32_t>();
+	if(!this->rev_built) build_rev();
+	return &this->rev32;
+}
+
+/* returns the 64-bit reverse CSR index, building it on first use */
+template<> inline const t_rev_csr<t_idx, t_weight>* MeanPayoffGame::get_rev_csr<t_idx, t_weight>(){
+	get_csr<t_idx, t_weight>();
+	if(!this->rev_built) build_rev();
+	return &this->rev64;
+}
+
+/* positional strategy of a player: each vertex of the player chooses one of its arcs,
+   the vertices of the opponent keep all of their arcs. The vertices choosing an arc
+   into each head are linked in intrusive doubly linked lists, so that switching the
+   arc of a vertex is O(1) and never allocates */
 class MPGProj{
 	public:
+	static constexpr unsigned long NONE = ULONG_MAX;
 	MPGProj(MeanPayoffGame *mpg);
 	~MPGProj();
 	void init_arbitrary(MeanPayoffGame *mpg, bool player);
-	void init_reverse(MPGProj *pi);
-	std::list<t_w_arc>* get_arcs(unsigned long u);
+	// the arc chosen by @u, arc_idx is NONE if @u is not a vertex of the player
+	const t_w_arc& get_arc(unsigned long u){ return this->chosen[u]; }
 	void set_arc(unsigned long u, t_w_arc arc);
+	// vertices choosing an arc into @head: first_tail(head), then next_tail(tail) until NONE
+	unsigned long first_tail(unsigned long head){ return this->first[head]; }
+	unsigned long next_tail(unsigned long tail){ return this->next[tail]; }
+	unsigned long footprint(); // bytes held
 
 	private:
 	unsigned long size;
-	std::list<t_w_arc>* arcs; // array of list<t_w_arcs>
+	t_w_arc* chosen;
+	unsigned long* first; // first tail choosing an arc into each head
+	unsigned long* next; // next and previous tails choosing an arc into the same head
+	unsigned long* prev;
+	void link(unsigned long u);
+	void unlink(unsigned long u);
 };
 
 #endif
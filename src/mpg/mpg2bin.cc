@@ -0,0 +1,59 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream> 
+#include <string>
+#include <fstream>
+#include <stdlib.h>
+#include "../conf.h"
+#include "mpg.h"
+
+using namespace std;
+
+/*****************************************************************************************
+*  This program converts a Mean Payoff Game from the ".dat" text format 
+*  into the binary MPG file format, see t_mpg_bin_header in mpg.h 
+*****************************************************************************************/
+
+ofstream o_stream;
+
+bool invalid_argc(int argc, char** argv);
+
+int main(int argc, char** argv){
+	if(invalid_argc(argc, argv)) return -1;
+	const char* input_file = argv[1];
+	const char* output_file = argv[2];
+	t_width width = argc == 4 ? (t_width) atoi(argv[3]) : WIDTH_AUTO;
+	try{
+		MeanPayoffGame mpg(input_file);
+		mpg.freeze(width);
+		mpg.save_bin(output_file);
+		cout << "Conversion completed (" << mpg.get_width() << "-bit, " 
+			<< mpg.get_n_0() + mpg.get_n_1() << " vertices, " << mpg.get_e() 
+			<< " arcs). See output file " << output_file << endl;
+	}catch(const char* msg){
+		cout << "Error: " << msg << endl;
+		return -1;
+	}
+	return 0;
+}
+
+/* checks argc validity */
+bool invalid_argc(int argc, char** argv){
+	if(argc == 3 || (argc == 4 && (atoi(argv[3]) == WIDTH_32 || atoi(argv[3]) == WIDTH_64))) 
+		return false;
+	cout << "Illegal input arguments!" << endl 
+	<< "mpg2bin usage is: mpg2bin <input mpg file> <output binary file> [32|64]" << endl;
+	return true;
+}
@@ -0,0 +1,226 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Binary MPG file format: save a frozen MPG, and mmap it back as its CSR arc storage.
+*  See t_mpg_bin_header in mpg.h for the layout.
+*****************************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mpg.h"
+
+using namespace std;
+
+/* rounds @pos up to the next multiple of MPG_BIN_ALIGN */
+static uint64_t bin_align(uint64_t pos){
+	return (pos + MPG_BIN_ALIGN - 1) / MPG_BIN_ALIGN * MPG_BIN_ALIGN;
+}
+
+/* writes @len bytes of @data at byte position @pos of @out, zero padding up to @pos */
+static void bin_write(ofstream& out, uint64_t pos, const void* data, uint64_t len){
+	static const char zeros[MPG_BIN_ALIGN] = {0};
+	uint64_t cur = out.tellp();
+	assert(cur <= pos && pos - cur < MPG_BIN_ALIGN);
+	out.write(zeros, pos - cur);
+	out.write((const char*) data, len);
+}
+
+/* sets the magic string, the version and the section positions of @h, 
+   given its width, n_0, n_1 and m */
+void mpg_bin_layout(t_mpg_bin_header* h){
+	unsigned long size = h->n_0 + h->n_1;
+	unsigned long idx_size = h->width == WIDTH_32 ? sizeof(uint32_t) : sizeof(t_idx);
+	unsigned long weight_size = h->width == WIDTH_32 ? sizeof(int32_t) : sizeof(t_weight);
+	memcpy(h->magic, MPG_BIN_MAGIC, sizeof(h->magic));
+	h->version = MPG_BIN_VERSION;
+	h->offset_pos = bin_align(sizeof(t_mpg_bin_header));
+	h->head_pos = bin_align(h->offset_pos + (size+1)*idx_size);
+	h->weight_pos = bin_align(h->head_pos + h->m*idx_size);
+	h->max_neg_pos = bin_align(h->weight_pos + h->m*weight_size);
+	h->file_size = h->max_neg_pos + size*sizeof(uint64_t);
+}
+
+/* writes the header @h, the CSR sections of @csr and @max_neg to @out */
+template<typename I, typename W>
+static void bin_write_sections(ofstream& out, t_mpg_bin_header& h, const t_csr<I, W>* csr, const t_nrg* max_neg){
+	unsigned long size = h.n_0 + h.n_1;
+	mpg_bin_layout(&h);
+	out.write((const char*) &h, sizeof(h));
+	bin_write(out, h.offset_pos, csr->offset, (size+1)*sizeof(I));
+	bin_write(out, h.head_pos, csr->head, h.m*sizeof(I));
+	bin_write(out, h.weight_pos, csr->weight, h.m*sizeof(W));
+	bin_write(out, h.max_neg_pos, max_neg, size*sizeof(uint64_t));
+}
+
+/* returns true iff @filename starts with the binary MPG magic string */
+bool MeanPayoffGame::is_bin_file(const char* filename){
+	char magic[8];
+	ifstream input(filename, ios::binary);
+	if(!input.is_open()) return false;
+	input.read(magic, sizeof(magic));
+	return input.gcount() == sizeof(magic) && memcmp(magic, MPG_BIN_MAGIC, sizeof(magic)) == 0;
+}
+
+/* writes @this to @filename in the binary MPG file format, with the current storage width */
+void MeanPayoffGame::save_bin(const char* filename){
+	assert(sizeof(t_nrg) == sizeof(uint64_t));
+	t_mpg_bin_header h;
+	memset(&h, 0, sizeof(h));
+	h.width = get_width();
+	h.n_0 = this->n_0;
+	h.n_1 = this->n_1;
+	h.m = this->e;
+	h.Top = get_Top();
+	h.min_weight = get_min_weight();
+	h.max_weight = get_max_weight();
+	h.min_deg = get_min_deg();
+	h.max_deg = get_max_deg();
+	ofstream out(filename, ios::binary | ios::trunc);
+	if(!out.is_open()) throw "cannot open output file";
+	if(this->width == WIDTH_32) bin_write_sections(out, h, &this->csr32, this->info.max_neg);
+	else bin_write_sections(out, h, &this->csr64, this->info.max_neg);
+	out.close();
+	if(out.fail()) throw "cannot write output file";
+}
+
+/* sets @end to the end of the section of @count elements of @elem_size bytes at @pos, returns
+   false if it is not aligned, starts before @start, or overflows or exceeds @file_size */
+static bool bin_section(uint64_t pos, uint64_t count, uint64_t elem_size, uint64_t start, uint64_t file_size, uint64_t* end){
+	uint64_t len;
+	if(pos % MPG_BIN_ALIGN != 0 || pos < start) return false;
+	if(__builtin_mul_overflow(count, elem_size, &len) || __builtin_add_overflow(pos, len, end)) return false;
+	return *end <= file_size;
+}
+
+/* returns true iff the header @h describes sections that lie in order, without overlapping, in the file,
+   and a Top below ULONG_MAX-1 */
+static bool bin_check_header(const t_mpg_bin_header* h, uint64_t file_size){
+	uint64_t size, end;
+	if(memcmp(h->magic, MPG_BIN_MAGIC, sizeof(h->magic)) != 0 || h->version != MPG_BIN_VERSION) return false;
+	if(h->width != WIDTH_32 && h->width != WIDTH_64) return false;
+	if(h->file_size != file_size || __builtin_add_overflow(h->n_0, h->n_1, &size) || size == 0 || size == UINT64_MAX) return false;
+	uint64_t idx_size = h->width == WIDTH_32 ? sizeof(uint32_t) : sizeof(t_idx);
+	uint64_t weight_size = h->width == WIDTH_32 ? sizeof(int32_t) : sizeof(t_weight);
+	if(h->Top >= ULONG_MAX-1) return false;
+	if(h->width == WIDTH_32 && (size >= UINT32_MAX || h->m >= UINT32_MAX || h->Top >= UINT32_MAX-1)) return false;
+	return bin_section(h->offset_pos, size+1, idx_size, sizeof(t_mpg_bin_header), file_size, &end) &&
+		bin_section(h->head_pos, h->m, idx_size, end, file_size, &end) &&
+		bin_section(h->weight_pos, h->m, weight_size, end, file_size, &end) &&
+		bin_section(h->max_neg_pos, size, sizeof(uint64_t), end, file_size, &end);
+}
+
+/* returns true iff the CSR sections at @base are well formed: the offsets start at 0,
+   every vertex has an arc, the last offset is m, and every head is a vertex, and iff
+   max_neg[], Top and the weight and degree ranges of the header match the arcs, in O(m) */
+template<typename I, typename W>
+static bool bin_check_arcs(const char* base, const t_mpg_bin_header* h){
+	uint64_t size = h->n_0 + h->n_1;
+	const I* offset = (const I*) (base + h->offset_pos);
+	const I* head = (const I*) (base + h->head_pos);
+	const W* weight = (const W*) (base + h->weight_pos);
+	const uint64_t* max_neg = (const uint64_t*) (base + h->max_neg_pos);
+	if(offset[0] != 0 || offset[size] != h->m) return false;
+	uint64_t Top = 0;
+	uint64_t min_deg = offset[1], max_deg = offset[1];
+	int64_t min_weight = weight[0], max_weight = weight[0];
+	for(uint64_t u=0; u < size; u++){
+		if(offset[u+1] <= offset[u]) return false; // degree >= 1, and no offset beyond m
+		uint64_t deg = offset[u+1] - offset[u];
+		min_deg = min(min_deg, deg);
+		max_deg = max(max_deg, deg);
+		uint64_t neg = 0;
+		for(I a=offset[u]; a < offset[u+1]; a++){
+			if(head[a] >= size || (int64_t) weight[a] == LONG_MIN) return false;
+			min_weight = min(min_weight, (int64_t) weight[a]);
+			max_weight = max(max_weight, (int64_t) weight[a]);
+			if(weight[a] < 0) neg = max(neg, (uint64_t) -(int64_t) weight[a]);
+		}
+		if(max_neg[u] != neg || __builtin_add_overflow(Top, neg, &Top)) return false;
+	}
+	return Top == h->Top && min_weight == h->min_weight && max_weight == h->max_weight &&
+		min_deg == h->min_deg && max_deg == h->max_deg;
+}
+
+/* maps @filename in memory and uses its sections as the frozen CSR arc storage,
+   the mapping is private, so that the arrays may be written without touching the file */
+void MeanPayoffGame::load_bin(const char* filename){
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) throw "cannot open input file";
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (uint64_t) st.st_size < sizeof(t_mpg_bin_header)){
+		close(fd);
+		throw "invalid binary MPG file";
+	}
+	void* addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(addr == MAP_FAILED) throw "cannot mmap input file";
+	const t_mpg_bin_header* h = (const t_mpg_bin_header*) addr;
+	char* base = (char*) addr;
+	if(!bin_check_header(h, st.st_size) ||
+		!(h->width == WIDTH_32 ? bin_check_arcs<uint32_t, int32_t>(base, h) : bin_check_arcs<t_idx, t_weight>(base, h))){
+		munmap(addr, st.st_size);
+		throw "invalid binary MPG file";
+	}
+	this->n_0 = h->n_0;
+	this->n_1 = h->n_1;
+	this->e = h->m;
+	init_frozen((t_width) h->width);
+	this->map_addr = addr;
+	this->map_len = st.st_size;
+	if(this->width == WIDTH_32){
+		this->csr32.offset = (uint32_t*) (base + h->offset_pos);
+		this->csr32.head = (uint32_t*) (base + h->head_pos);
+		this->csr32.weight = (int32_t*) (base + h->weight_pos);
+	}else{
+		this->csr64.offset = (t_idx*) (base + h->offset_pos);
+		this->csr64.head = (t_idx*) (base + h->head_pos);
+		this->csr64.weight = (t_weight*) (base + h->weight_pos);
+	}
+	this->info.Top = h->Top;
+	this->info.max_neg = (t_nrg*) (base + h->max_neg_pos);
+	this->info.min_weight = h->min_weight;
+	this->info.max_weight = h->max_weight;
+	this->info.min_deg = h->min_deg;
+	this->info.max_deg = h->max_deg;
+	this->info.stale = false;
+}
+
+/* releases the mapping of the binary file, max_neg[] is first copied to the heap */
+void MeanPayoffGame::unmap(){
+	if(this->map_addr == NULL) return;
+	if(this->info.max_neg != NULL){
+		unsigned long size = this->n_0 + this->n_1;
+		t_nrg* max_neg = new t_nrg[size];
+		copy(this->info.max_neg, this->info.max_neg + size, max_neg);
+		this->info.max_neg = max_neg;
+	}
+	munmap(this->map_addr, this->map_len);
+	this->map_addr = NULL;
+	this->map_len = 0;
+	this->csr32.offset = NULL;
+	this->csr32.head = NULL;
+	this->csr32.weight = NULL;
+	this->csr64.offset = NULL;
+	this->csr64.head = NULL;
+	this->csr64.weight = NULL;
+}
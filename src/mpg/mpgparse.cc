@@ -0,0 +1,260 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Parallel loader of the ".dat" MPG text format: the file is mmap'ed, its arc section 
+*  is split at newline boundaries into chunks parsed by several threads, then the arcs 
+*  are merged into the CSR arc storage in file order.
+*****************************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <charconv>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mpg.h"
+
+using namespace std;
+
+#define PARSE_MIN_CHUNK (1 << 20) // min number of bytes of arc data per parsing thread
+
+/* an arc as read from the text file, I is wide enough for the vertex indexes */
+template<typename I>
+struct t_arc_rec{
+	I tail, head;
+	t_weight weight;
+};
+
+/* the arcs parsed from a chunk of the arc section */
+template<typename I>
+struct t_chunk{
+	vector<t_arc_rec<I> > arcs;
+	t_weight min_weight;
+	t_weight max_weight;
+	const char* error; // NULL if the chunk was parsed successfully
+};
+
+/* skips blanks, not newlines */
+static inline const char* skip_blanks(const char* p, const char* end){
+	while(p < end && (*p == ' ' || *p == '\t')) p++;
+	return p;
+}
+
+/* returns the beginning of the line following the one of @p */
+static inline const char* next_line(const char* p, const char* end){
+	const char* nl = (const char*) memchr(p, '\n', end - p);
+	return nl == NULL ? end : nl + 1;
+}
+
+/* returns true iff the line at @p is blank or a comment */
+static inline bool skip_line(const char* p, const char* end){
+	p = skip_blanks(p, end);
+	return p == end || *p == '#' || *p == '\n' || *p == '\r';
+}
+
+/* parses the integer at @p into @v, skipping leading blanks, 
+   returns the position after the integer or NULL on failure */
+static inline const char* parse_long(const char* p, const char* end, long& v){
+	p = skip_blanks(p, end);
+	from_chars_result r = from_chars(p, end, v);
+	if(r.ec != errc()) return NULL;
+	return r.ptr;
+}
+
+/* parses the next non-comment line of the header into @vals, 
+   returns the beginning of the following line */
+static const char* parse_header_line(const char* p, const char* end, long* vals, int num_vals){
+	while(p < end && skip_line(p, end)) p = next_line(p, end);
+	if(p == end) throw "unexpected end of MPG file header";
+	for(int i=0; i < num_vals; i++){
+		p = parse_long(p, end, vals[i]);
+		if(p == NULL || vals[i] < 0) throw "invalid MPG file header";
+	}
+	return next_line(p, end);
+}
+
+/* parses the arc lines between @p and @end into @chunk */
+template<typename I>
+static void parse_chunk(const char* p, const char* end, unsigned long size, t_chunk<I>* chunk){
+	chunk->arcs.reserve((end - p) / 8);
+	chunk->min_weight = chunk->max_weight = 0;
+	chunk->error = NULL;
+	bool first = true;
+	while(p < end){
+		if(skip_line(p, end)){ // skip comments and blank lines
+			p = next_line(p, end);
+			continue;
+		}
+		long tail, head, weight;
+		p = parse_long(p, end, tail);
+		if(p != NULL) p = parse_long(p, end, head);
+		if(p != NULL) p = parse_long(p, end, weight);
+		if(p == NULL){
+			chunk->error = "invalid arc line in MPG file";
+			return;
+		}
+		if(tail < 0 || (unsigned long) tail >= size || head < 0 || (unsigned long) head >= size){
+			chunk->error = "arc index out of range in MPG file";
+			return;
+		}
+		if(weight == LONG_MIN){ // its opposite, the energy it requires, is not a long
+			chunk->error = "weight out of range in MPG file";
+			return;
+		}
+		t_arc_rec<I> arc;
+		arc.tail = tail;
+		arc.head = head;
+		arc.weight = weight;
+		chunk->arcs.push_back(arc);
+		if(first || weight < chunk->min_weight) chunk->min_weight = weight;
+		if(first || weight > chunk->max_weight) chunk->max_weight = weight;
+		first = false;
+		p = next_line(p, end);
+	}
+}
+
+/* fills @csr with the arcs of @chunks in file order, @cursor holds the out-degrees 
+   of the vertices and is overwritten, the chunks are released once copied */
+template<typename I, typename CI, typename CW>
+static void csr_fill_chunks(t_csr<CI, CW>& csr, vector<t_chunk<I> >& chunks, t_idx* cursor){
+	unsigned long size = csr.n;
+	csr.offset = new CI[size+1];
+	csr.head = new CI[csr.m];
+	csr.weight = new CW[csr.m];
+	t_idx a = 0;
+	for(unsigned long u=0; u < size; u++){
+		csr.offset[u] = a;
+		a += cursor[u];
+		cursor[u] = csr.offset[u];
+	}
+	csr.offset[size] = a;
+	for(unsigned long c=0; c < chunks.size(); c++){
+		typename vector<t_arc_rec<I> >::iterator it = chunks[c].arcs.begin();
+		for(it; it != chunks[c].arcs.end(); it++){
+			t_idx i = cursor[it->tail]++;
+			csr.head[i] = it->head;
+			csr.weight[i] = it->weight;
+		}
+		vector<t_arc_rec<I> >().swap(chunks[c].arcs);
+	}
+}
+
+/**
+* Initializes @this MPG by loading the input file @filename, 
+* see "dat/mpg.dat" for an MPG file format example.
+* @this is left frozen with the narrowest width that fits.
+**/
+void MeanPayoffGame::load(const char* filename){
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) throw "cannot open input file";
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0){
+		close(fd);
+		throw "empty or unreadable input file";
+	}
+	void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(addr == MAP_FAILED) throw "cannot mmap input file";
+	madvise(addr, st.st_size, MADV_SEQUENTIAL);
+	const char* p = (const char*) addr;
+	const char* end = p + st.st_size;
+	try{
+		long vals[2];
+		p = parse_header_line(p, end, vals, 2); // number of vertices
+		this->n_0 = vals[0];
+		this->n_1 = vals[1];
+		p = parse_header_line(p, end, vals, 1); // number of arcs
+		unsigned long num_arcs = vals[0];
+		if(this->n_0 + this->n_1 < UINT32_MAX) load_arcs<uint32_t>(p, end, num_arcs);
+		else load_arcs<t_idx>(p, end, num_arcs);
+	}catch(const char* msg){
+		munmap(addr, st.st_size);
+		throw;
+	}
+	munmap(addr, st.st_size);
+}
+
+/* parses the arc section between @p and @end on several threads, then builds 
+   the metadata and the CSR arc storage, I is wide enough for the vertex indexes */
+template<typename I>
+void MeanPayoffGame::load_arcs(const char* p, const char* end, unsigned long num_arcs){
+	unsigned long size = this->n_0 + this->n_1;
+	// split the arc section at newline boundaries
+	unsigned long num_threads = max(1u, thread::hardware_concurrency());
+	num_threads = min(num_threads, (unsigned long) (end - p) / PARSE_MIN_CHUNK + 1);
+	vector<const char*> bounds(num_threads+1);
+	bounds[0] = p;
+	bounds[num_threads] = end;
+	for(unsigned long i=1; i < num_threads; i++){
+		const char* q = p + (end - p) / num_threads * i;
+		bounds[i] = q <= bounds[i-1] ? bounds[i-1] : next_line(q-1, end);
+	}
+	// parse the chunks, chunk 0 on the calling thread
+	vector<t_chunk<I> > chunks(num_threads);
+	vector<thread> workers;
+	for(unsigned long i=1; i < num_threads; i++)
+		workers.push_back(thread(parse_chunk<I>, bounds[i], bounds[i+1], size, &chunks[i]));
+	parse_chunk<I>(bounds[0], bounds[1], size, &chunks[0]);
+	for(unsigned long i=0; i < workers.size(); i++) workers[i].join();
+	// merge the metadata
+	this->e = 0;
+	this->info.min_weight = this->info.max_weight = 0;
+	bool first = true;
+	for(unsigned long c=0; c < num_threads; c++){
+		if(chunks[c].error != NULL) throw chunks[c].error;
+		if(chunks[c].arcs.empty()) continue;
+		this->e += chunks[c].arcs.size();
+		if(first || chunks[c].min_weight < this->info.min_weight) this->info.min_weight = chunks[c].min_weight;
+		if(first || chunks[c].max_weight > this->info.max_weight) this->info.max_weight = chunks[c].max_weight;
+		first = false;
+	}
+	if(this->e != num_arcs) throw "arcs count mismatch in MPG file";
+	t_idx* deg = new t_idx[size];
+	fill_n(deg, size, 0);
+	this->info.max_neg = new t_nrg[size];
+	fill_n(this->info.max_neg, size, 0);
+	for(unsigned long c=0; c < num_threads; c++){
+		typename vector<t_arc_rec<I> >::iterator it = chunks[c].arcs.begin();
+		for(it; it != chunks[c].arcs.end(); it++){
+			deg[it->tail]++;
+			if(it->weight < 0 && (t_nrg) -it->weight > this->info.max_neg[it->tail])
+				this->info.max_neg[it->tail] = -it->weight;
+		}
+	}
+	this->info.Top = 0;
+	this->info.min_deg = this->info.max_deg = size > 0 ? deg[0] : 0;
+	for(unsigned long u=0; u < size; u++){
+		if(__builtin_add_overflow(this->info.Top, this->info.max_neg[u], &this->info.Top) || this->info.Top >= ULONG_MAX-1){
+			delete [] deg;
+			delete [] this->info.max_neg;
+			this->info.max_neg = NULL;
+			throw "MPG energies overflow";
+		}
+		if(deg[u] < this->info.min_deg) this->info.min_deg = deg[u];
+		if(deg[u] > this->info.max_deg) this->info.max_deg = deg[u];
+	}
+	this->info.stale = false;
+	// build the CSR arc storage of the selected width
+	init_frozen(select_width());
+	if(this->width == WIDTH_32) csr_fill_chunks(this->csr32, chunks, deg);
+	else csr_fill_chunks(this->csr64, chunks, deg);
+	delete [] deg;
+}
@@ -12,215 +12,392 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include <iostream> 
+#include <iostream>
 #include <string>
 #include <fstream>
-#include <sstream>
-#include <random>
-#include <chrono>
-#include <map>
-#include <set>
-#include <list>
-#include <vector>
+#include <charconv>
+#include <algorithm>
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 #include <time.h> /* time */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "../conf.h"
 #include "mpg.h"
 
 using namespace std;
 
 /*****************************************************************************************
-*  This program translates a Parity Game generated by "pgsolver" into a Mean Payoff Game 
+*  This program translates a Parity Game generated by "pgsolver" into a Mean Payoff Game.
+*  The pg file is mmap'ed and read twice: the first pass relabels the vertices and
+*  counts the arcs into flat arrays, the second one streams the arcs straight to the
+*  output file, so that the game is never resident in memory.
+*  The output is in the ".dat" text format, or in the binary MPG file format
+*  (see t_mpg_bin_header in mpg.h) if the output file name ends with ".bin".
 *****************************************************************************************/
 
 char* INPUT_FILE;
 const char* OUTPUT_FILE="data/pg_mpg.dat";
 const bool VERBOSE_MODE = true; // initialization needed for mpg.h
 unsigned long MAX_WEIGHT=0;
-unsigned long MAX_PRIORITY=0;
-// maps pg id to mpg id
-map<unsigned long, unsigned long> id_map;
 
 ofstream o_stream;
 
-struct t_node{
-	unsigned long id;
-	long priority;
-	bool owner; // true for 1, MAX, white
-	vector<unsigned long> suc;
-};
+#define NO_OWNER 2 // owner of the pg ids that are not defined (yet)
+#define WRITER_BUF_SIZE (1 << 20) // bytes buffered by each output stream
 
+/* the parity game as seen by the translation: a relabelling of its vertices */
 struct t_pg{
-	unsigned long n;
-	unsigned long n_0;
-	vector<t_node> nodes;
+	unsigned long n; // number of pg ids, that is the "parity" value plus one
+	unsigned long n_0; // number of vertices owned by MIN
+	unsigned long m; // number of MPG arcs, self loops excluded
+	char* owner; // owner of each pg id: 0 MIN, 1 MAX, NO_OWNER
+	unsigned long* rank; // index of each pg id among the vertices of its owner, in file order
+	unsigned long* deg; // number of MPG arcs out of each pg id
+	const char* nodes; // beginning of the node lines
+	const char* end; // end of the file
+};
+
+/* an output stream writing at increasing positions of a file */
+struct t_writer{
+	int fd;
+	uint64_t pos; // file position of buf[0]
+	char* buf;
+	unsigned long len;
 };
 
 bool invalid_argc(int a);
-void load(const char* f, t_pg &pg);
-void compute_id_map(t_pg &pg);
-void translate_pg2mpg(t_pg &pg, MeanPayoffGame &mpg);
-void post_process(MeanPayoffGame &mpg);
+void load(const char* p, const char* end, t_pg &pg);
+void translate_pg2mpg_text(t_pg &pg, int fd);
+template<typename I, typename W>
+void translate_pg2mpg_bin(t_pg &pg, int fd, t_width width);
 
 int main(int argc, char** argv){
-	if(invalid_argc(argc)) return -1;	
+	if(invalid_argc(argc)) return -1;
 	/* initialize random seed: */
 	srand(time(NULL));
 	INPUT_FILE = argv[1];
-	MAX_WEIGHT = atoi(argv[2]);
-	o_stream.open(OUTPUT_FILE);
+	MAX_WEIGHT = atol(argv[2]);
+	if(argc == 4) OUTPUT_FILE = argv[3];
+	unsigned long out_len = strlen(OUTPUT_FILE);
+	bool binary = out_len >= 4 && strcmp(OUTPUT_FILE + out_len - 4, ".bin") == 0;
 	t_pg pg;
-	load(INPUT_FILE, pg);
-	compute_id_map(pg);
-	unsigned long n_0 = pg.n_0;
-	unsigned long n_1 = id_map.size()-n_0;
-	MeanPayoffGame mpg(n_0, n_1);
-	translate_pg2mpg(pg, mpg);
-	mpg.print(); // write to ouput file 
-	o_stream.close();
-	cout << "Translation completed. See output file " << OUTPUT_FILE << endl;
+	pg.owner = NULL;
+	pg.rank = pg.deg = NULL;
+	void* addr = MAP_FAILED;
+	struct stat st;
+	int fd = -1;
+	try{
+		int in_fd = open(INPUT_FILE, O_RDONLY);
+		if(in_fd < 0) throw "cannot open input file";
+		if(fstat(in_fd, &st) != 0 || st.st_size == 0){
+			close(in_fd);
+			throw "empty or unreadable input file";
+		}
+		addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+		close(in_fd);
+		if(addr == MAP_FAILED) throw "cannot mmap input file";
+		madvise(addr, st.st_size, MADV_SEQUENTIAL);
+		load((const char*) addr, (const char*) addr + st.st_size, pg);
+		fd = open(OUTPUT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd < 0) throw "cannot open output file";
+		if(!binary) translate_pg2mpg_text(pg, fd);
+		// MAX_WEIGHT bounds the weights, n*MAX_WEIGHT bounds Top
+		else if(MAX_WEIGHT <= LONG_MAX &&
+			mpg_select_width(pg.n, pg.m, -(t_weight) MAX_WEIGHT, MAX_WEIGHT, mpg_top_bound(pg.n, MAX_WEIGHT)) == WIDTH_32)
+			translate_pg2mpg_bin<uint32_t, int32_t>(pg, fd, WIDTH_32);
+		else translate_pg2mpg_bin<t_idx, t_weight>(pg, fd, WIDTH_64);
+	}catch(const char* msg){
+		cout << "Error: " << msg << endl;
+		if(fd >= 0) close(fd);
+		if(addr != MAP_FAILED) munmap(addr, st.st_size);
+		delete [] pg.owner;
+		delete [] pg.rank;
+		delete [] pg.deg;
+		return -1;
+	}
+	close(fd);
+	munmap(addr, st.st_size);
+	delete [] pg.owner;
+	delete [] pg.rank;
+	delete [] pg.deg;
+	cout << "Translation completed (" << pg.n << " vertices, " << pg.m
+		<< " arcs). See output file " << OUTPUT_FILE << endl;
 	return 0;
 }
 
-/* Translates the parity game @pg into an MPG @mpg */
-void translate_pg2mpg(t_pg &pg, MeanPayoffGame &mpg){
-//	unsigned seed = chrono::system_clock::now().time_since_epoch().count();
-//	default_random_engine generator (seed);
-//	normal_distribution<double> distribution (0.0, MAX_WEIGHT/4);
-	vector<t_node>::iterator it = pg.nodes.begin();	
-	for(it; it != pg.nodes.end(); it++){
-		t_node node = *it;
-		vector<unsigned long>::iterator it2 = node.suc.begin();
-		for(it2; it2 != node.suc.end(); it2++){
-			unsigned long head_idx = *it2;
-			if(id_map[head_idx] != id_map[node.id]){ // assume no self loops 
-				t_w_arc arc;
-				arc.head_idx = id_map[head_idx]; 
-				//compute the corresponding weight for MPG
-//				double root_exp = 1.0/MAX_PRIORITY;
-//				double base = -pow(MAX_WEIGHT, root_exp);
-//				long weight = pow(base, node.priority); 	
-			/*	int threshold = rand()%100;
-				long weight;
-				if(threshold <= 25){
-					weight = -1;	
-				}else if(threshold > 25 && threshold <= 40){
-					weight = 0;
-				}else{
-					weight = distribution(generator);
-				}	*/
-				arc.weight = pow(-1,rand()%2)*(rand()%(MAX_WEIGHT+1)); 
-				/*unsigned int SHIFT_FACTOR=90; 
-				arc.weight += MAX_WEIGHT*(SHIFT_FACTOR/100.0); */
-				mpg.push_arc(id_map[node.id], arc); 
-			}
+/* returns a random weight in [-MAX_WEIGHT, MAX_WEIGHT] */
+static inline long random_weight(){
+	long sign = rand()%2 ? -1 : 1;
+	return sign * (long) (rand()%(MAX_WEIGHT+1));
+}
+
+/* opens a writer on @fd at file position @pos */
+static void writer_open(t_writer* w, int fd, uint64_t pos){
+	w->fd = fd;
+	w->pos = pos;
+	w->buf = new char[WRITER_BUF_SIZE];
+	w->len = 0;
+}
+
+/* writes the buffered bytes of @w to its file */
+static void writer_flush(t_writer* w){
+	unsigned long done = 0;
+	while(done < w->len){
+		ssize_t r = pwrite(w->fd, w->buf + done, w->len - done, w->pos + done);
+		if(r <= 0) throw "cannot write output file";
+		done += r;
+	}
+	w->pos += w->len;
+	w->len = 0;
+}
+
+/* flushes @w and releases its buffer */
+static void writer_close(t_writer* w){
+	writer_flush(w);
+	delete [] w->buf;
+	w->buf = NULL;
+}
+
+/* appends @len bytes of @data to @w */
+static inline void writer_put(t_writer* w, const void* data, unsigned long len){
+	if(w->len + len > WRITER_BUF_SIZE) writer_flush(w);
+	if(len > WRITER_BUF_SIZE){ // too large to be buffered
+		uint64_t pos = w->pos;
+		for(unsigned long done=0; done < len; done += WRITER_BUF_SIZE){
+			w->len = min(len - done, (unsigned long) WRITER_BUF_SIZE);
+			memcpy(w->buf, (const char*) data + done, w->len);
+			writer_flush(w);
 		}
+		assert(w->pos == pos + len);
+		return;
 	}
+	memcpy(w->buf + w->len, data, len);
+	w->len += len;
 }
 
-/* Maps @pg vertices ids into MPG vertices ids,
-   this is part of the translation procedure */
-void compute_id_map(t_pg &pg){
-	unsigned long c_MIN=0, c_MAX=0, mpg_id=0, tot_nodes;
-	vector<t_node>::iterator it = pg.nodes.begin();
-	id_map.clear();
-	for(it; it != pg.nodes.end(); it++){
-		t_node node = *it;
-		tot_nodes++;
-		if(id_map.count(node.id)==0){
-			if(node.owner){ // owner is MAX
-				mpg_id = pg.n_0 + c_MAX++;
-				assert(mpg_id <= pg.n);
-				pair<unsigned long, unsigned long> entry(node.id, mpg_id);
-				id_map.insert(entry);
-			}else{ // owner is MIN
-				mpg_id = c_MIN++;
-				assert(mpg_id <= pg.n);
-				pair<unsigned long, unsigned long> entry(node.id, mpg_id);
-				id_map.insert(entry);
-			}
-		}else throw "something goes wrong";	
+/* appends the decimal representation of @v and the char @sep to @w */
+template<typename T>
+static inline void writer_put_num(t_writer* w, T v, char sep){
+	if(w->len + 32 > WRITER_BUF_SIZE) writer_flush(w);
+	char* p = to_chars(w->buf + w->len, w->buf + WRITER_BUF_SIZE, v).ptr;
+	*p++ = sep;
+	w->len = p - w->buf;
+}
+
+/* skips blanks, not newlines */
+static inline const char* skip_blanks(const char* p, const char* end){
+	while(p < end && (*p == ' ' || *p == '\t')) p++;
+	return p;
+}
+
+/* returns the beginning of the line following the one of @p */
+static inline const char* next_line(const char* p, const char* end){
+	const char* nl = (const char*) memchr(p, '\n', end - p);
+	return nl == NULL ? end : nl + 1;
+}
+
+/* returns true iff the line at @p is blank or a comment */
+static inline bool skip_line(const char* p, const char* end){
+	p = skip_blanks(p, end);
+	return p == end || *p == '#' || *p == '\n' || *p == '\r';
+}
+
+/* parses the non negative integer at @p into @v, skipping leading blanks,
+   returns the position after the integer */
+static inline const char* parse_ulong(const char* p, const char* end, unsigned long& v){
+	p = skip_blanks(p, end);
+	from_chars_result r = from_chars(p, end, v);
+	if(r.ec != errc()) throw "invalid node line in pg file";
+	return r.ptr;
+}
+
+/* parses the "id priority owner" prefix of the node line at @p,
+   returns the position of its successors list */
+static inline const char* parse_node(const char* p, const char* end, unsigned long& id, unsigned long& owner){
+	unsigned long priority;
+	p = parse_ulong(p, end, id);
+	p = parse_ulong(p, end, priority);
+	p = parse_ulong(p, end, owner);
+	if(owner > 1) throw "invalid owner in pg file";
+	return p;
+}
+
+/* parses the next successor of the list at @p into @head, 
+   returns the position after it, or NULL at the end of the list */
+static inline const char* next_successor(const char* p, const char* end, bool first, unsigned long& head){
+	if(!first){
+		if(p == end || *p != ',') return NULL;
+		p++;
+	}
+	return parse_ulong(p, end, head);
+}
+
+/* reads the header and the node lines of the pg file between @p and @end,
+   and relabels the pg ids into MPG vertices: MIN vertices come first,
+   each player's vertices keep their file order */
+void load(const char* p, const char* end, t_pg &pg){
+	while(p < end && skip_line(p, end)) p = next_line(p, end);
+	p = skip_blanks(p, end);
+	if(end - p < 6 || strncmp(p, "parity", 6) != 0) throw "invalid pg file header";
+	unsigned long max_id;
+	p = parse_ulong(p + 6, end, max_id);
+	pg.n = max_id + 1;
+	pg.n_0 = pg.m = 0;
+	pg.owner = new char[pg.n];
+	pg.rank = new unsigned long[pg.n];
+	pg.deg = new unsigned long[pg.n];
+	fill_n(pg.owner, pg.n, NO_OWNER);
+	p = next_line(p, end);
+	pg.nodes = p;
+	pg.end = end;
+	unsigned long num_nodes[2] = {0, 0};
+	while(p < end){
+		if(skip_line(p, end)){ // skip comments
+			p = next_line(p, end);
+			continue;
+		}
+		unsigned long id, owner, head;
+		p = parse_node(p, end, id, owner);
+		if(id >= pg.n) throw "node id out of range in pg file";
+		if(pg.owner[id] != NO_OWNER) throw "duplicated node id in pg file";
+		pg.owner[id] = owner;
+		pg.rank[id] = num_nodes[owner]++;
+		pg.deg[id] = 0;
+		const char* q;
+		for(bool first=true; (q = next_successor(p, end, first, head)) != NULL; first=false){
+			p = q;
+			if(head >= pg.n) throw "successor id out of range in pg file";
+			if(head != id) pg.deg[id]++; // assume no self loops
+		}
+		pg.m += pg.deg[id];
+		p = next_line(p, end);
 	}
-//	cout << tot_nodes << " " << pg.n+1 << endl;
-	assert(tot_nodes==pg.n+1);
-}
-
-/* Splits string @s into vector @elems with char delimiter @delim */
-vector<unsigned long> &split(const string &s, char delim, vector<unsigned long> &elems) {
-    stringstream ss(s);
-    string item;
-    while (getline(ss, item, delim)) {
-	unsigned long i_item = atoi(item.c_str());
-        elems.push_back(i_item);
-    }
-    return elems;
-}
-
-/* Splits string @s with char delimiter @delim*/
-vector<unsigned long> split(const string &s, char delim) {
-    vector<unsigned long> elems;
-    split(s, delim, elems);
-    return elems;
-}
-
-/* loads a pg from filename */
-void load(const char* filename, t_pg &pg){
-	/*
-	* init_steps:
-	* 0: name and size
-	* 1: node data
-	*/
-	int init_step = 0;
-	/**/
-	ifstream input(filename);
-	string line;
-	if(input.is_open()){
-		unsigned long long num_line = 0;
-		unsigned long n=0, n_0=0, idx=0, n_id, n_owner;
-		long n_priority;
-		string name, l_suc;
-		vector<unsigned long> v_suc;
-		while(getline(input, line)){
-			num_line++;
-			if(line.compare(0,1,"#")==0) // skip comments
+	if(num_nodes[0] + num_nodes[1] != pg.n) throw "missing node ids in pg file";
+	pg.n_0 = num_nodes[0];
+}
+
+/* returns the MPG vertex of the pg id @id */
+static inline unsigned long mpg_id(t_pg &pg, unsigned long id){
+	return pg.owner[id] ? pg.n_0 + pg.rank[id] : pg.rank[id];
+}
+
+/* calls @emit(tail, head) on every MPG arc, sorted by tail,
+   by sweeping over the node lines once for each player */
+template<typename F>
+static void for_each_arc(t_pg &pg, F emit){
+	for(unsigned long player=MIN; player <= MAX; player++){
+		const char* p = pg.nodes;
+		while(p < pg.end){
+			if(skip_line(p, pg.end)){
+				p = next_line(p, pg.end);
 				continue;
-			istringstream iss(line);
-			switch(init_step){
-				case 0:
-					iss >> name >> n;
-					pg.n = n;
-					init_step++;
-				break;
-				case 1:
-					assert(idx <= n);
-					iss >> n_id >> n_priority >> n_owner >> l_suc;
-					v_suc = split(l_suc, ',');
-					t_node n_node;
-					n_node.id = n_id;
-					n_node.priority = n_priority;
-					if(n_priority > MAX_PRIORITY) MAX_PRIORITY = n_priority;
-					n_node.owner = n_owner == 1 ? true : false;
-					n_0 += ((n_owner+1)%2);
-					n_node.suc = v_suc;
-					pg.nodes.push_back(n_node);
-					idx++;
-				break;
 			}
+			unsigned long id, owner, head;
+			p = parse_node(p, pg.end, id, owner);
+			if(owner == player){
+				unsigned long tail = mpg_id(pg, id);
+				const char* q;
+				for(bool first=true; (q = next_successor(p, pg.end, first, head)) != NULL; first=false){
+					p = q;
+					if(pg.owner[head] == NO_OWNER) throw "undefined successor id in pg file";
+					if(head != id) emit(tail, mpg_id(pg, head));
+				}
+			}
+			p = next_line(p, pg.end);
 		}
-		pg.n_0 = n_0;
-		assert(idx==n+1);
-		input.close();
-	}else throw "cannot open input file";
+	}
+}
+
+/* streams the MPG translation of @pg to @fd in the ".dat" text format */
+void translate_pg2mpg_text(t_pg &pg, int fd){
+	t_writer w;
+	writer_open(&w, fd, 0);
+	const char* title = "## Mean Payoff Game definition: \n";
+	writer_put(&w, title, strlen(title));
+	writer_put_num(&w, pg.n_0, ' ');
+	writer_put_num(&w, pg.n - pg.n_0, '\n');
+	writer_put_num(&w, pg.m, '\n');
+	for_each_arc(pg, [&](unsigned long tail, unsigned long head){
+		writer_put_num(&w, tail, ' ');
+		writer_put_num(&w, head, ' ');
+		writer_put_num(&w, random_weight(), '\n');
+	});
+	const char* footer = "## End of MPG definition.\n";
+	writer_put(&w, footer, strlen(footer));
+	writer_close(&w);
+}
+
+/* streams the MPG translation of @pg to @fd in the binary MPG file format
+   with vertex indexes of type I and weights of type W */
+template<typename I, typename W>
+void translate_pg2mpg_bin(t_pg &pg, int fd, t_width width){
+	assert(sizeof(t_nrg) == sizeof(uint64_t));
+	t_mpg_bin_header h;
+	memset(&h, 0, sizeof(h));
+	h.width = width;
+	h.n_0 = pg.n_0;
+	h.n_1 = pg.n - pg.n_0;
+	h.m = pg.m;
+	mpg_bin_layout(&h);
+	// offsets, from the degrees relabelled by MPG vertex
+	I* offset = new I[pg.n+1];
+	offset[0] = 0;
+	for(unsigned long id=0; id < pg.n; id++) offset[mpg_id(pg, id)+1] = pg.deg[id];
+	h.min_deg = pg.n > 0 ? offset[1] : 0;
+	for(unsigned long u=0; u < pg.n; u++){
+		h.min_deg = min(h.min_deg, (uint64_t) offset[u+1]);
+		h.max_deg = max(h.max_deg, (uint64_t) offset[u+1]);
+		offset[u+1] += offset[u];
+	}
+	t_writer w_offset, w_head, w_weight, w_max_neg;
+	writer_open(&w_offset, fd, h.offset_pos);
+	writer_put(&w_offset, offset, (pg.n+1)*sizeof(I));
+	writer_close(&w_offset);
+	delete [] offset;
+	// arcs, max_neg and weight range
+	writer_open(&w_head, fd, h.head_pos);
+	writer_open(&w_weight, fd, h.weight_pos);
+	writer_open(&w_max_neg, fd, h.max_neg_pos);
+	unsigned long u = 0; // next vertex whose max_neg has to be written
+	uint64_t max_neg = 0; // of vertex u
+	bool first = true;
+	for_each_arc(pg, [&](unsigned long tail, unsigned long head){
+		for(; u < tail; u++, max_neg=0){
+			writer_put(&w_max_neg, &max_neg, sizeof(max_neg));
+			h.Top += max_neg;
+		}
+		I i_head = head;
+		W weight = random_weight();
+		writer_put(&w_head, &i_head, sizeof(I));
+		writer_put(&w_weight, &weight, sizeof(W));
+		if(weight < 0 && (uint64_t) -weight > max_neg) max_neg = -weight;
+		if(first || weight < h.min_weight) h.min_weight = weight;
+		if(first || weight > h.max_weight) h.max_weight = weight;
+		first = false;
+	});
+	for(; u < pg.n; u++, max_neg=0){
+		writer_put(&w_max_neg, &max_neg, sizeof(max_neg));
+		h.Top += max_neg;
+	}
+	writer_close(&w_head);
+	writer_close(&w_weight);
+	writer_close(&w_max_neg);
+	if(pwrite(fd, &h, sizeof(h), 0) != sizeof(h)) throw "cannot write output file";
+	// the sections are padded with zeros up to their aligned positions
+	if(ftruncate(fd, h.file_size) != 0) throw "cannot write output file";
 }
 
 /* checks argc validity */
 bool invalid_argc(int argc){
-	if(argc != 3){
-		cout << "Illegal input arguments!" << endl 
-		<< "pg2mpg usage is: pg2mpg <input pg file> <max_weight>" << endl;
+	if(argc != 3 && argc != 4){
+		cout << "Illegal input arguments!" << endl
+		<< "pg2mpg usage is: pg2mpg <input pg file> <max_weight> [output file]" << endl
+		<< "the output is written in binary MPG format if the output file ends with \".bin\"" << endl;
 		return true;
 	}
 	return false;
@@ -0,0 +1,150 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <string>
+#include <assert.h>
+#include "portfolio.h"
+
+using namespace std;
+
+// period of the polls of the cancel flags of the caller while the engines race
+#define PORTFOLIO_POLL_PERIOD chrono::milliseconds(1)
+
+// the state shared by the engines
+struct t_portfolio_run{
+	mutex lock;
+	condition_variable done; // notified when an engine returns
+	unsigned int running = 0; // engines that did not return yet
+	bool cancel[PORTFOLIO_NUM_ENGINES] = {false, false}; // of each engine, set by the winner or the caller
+	int winner = -1;
+	const char* error = NULL; // first error thrown by an engine
+	t_status status = SOLVE_CONVERGED; // of the engines stopped early, before any finished
+	t_nrg* energy; // max of the energies of the engines stopped early, until one finishes
+	chrono::steady_clock::time_point start;
+	double seconds;
+};
+
+static const char* PORTFOLIO_ENGINE_NAMES[PORTFOLIO_NUM_ENGINES] = {"vi", "kasi"};
+
+// runs @engine on @mpg, its energies are copied into @run unless another engine won first
+static void portfolio_run(MeanPayoffGame *mpg, t_portfolio_engine engine, const t_portfolio_conf* conf, t_portfolio_run* run){
+	unsigned long size = mpg->get_n_0() + mpg->get_n_1();
+	SolverWorkspace local;
+	SolverWorkspace* ws = conf->workspace[engine] != NULL ? conf->workspace[engine] : &local;
+	t_nrg* energy = ws->get<t_nrg>(WS_ENERGY, size);
+	t_solve_stats stats;
+	t_mem_report mem;
+	t_status status;
+	try{
+		if(engine == PORTFOLIO_VI){
+			t_vi_conf c = conf->vi;
+			c.cancel = &run->cancel[engine];
+			c.workspace = ws;
+			c.stats = &stats;
+			c.memory = &mem;
+			status = VI_compute_energy(mpg, energy, c);
+		}else{
+			t_kasi_conf c = conf->kasi;
+			c.cancel = &run->cancel[engine];
+			c.workspace = ws;
+			c.stats = &stats;
+			c.memory = &mem;
+			status = KASI_lowerWeakUpperBound(mpg, mpg->get_Top()+1, energy, c);
+		}
+	}catch(const char* msg){
+		lock_guard<mutex> guard(run->lock);
+		if(run->error == NULL) run->error = msg;
+		return;
+	}
+	lock_guard<mutex> guard(run->lock);
+	STAT_REPORT(engine == PORTFOLIO_VI ? conf->vi.stats : conf->kasi.stats, stats); // both may be the same report
+	t_mem_report* report = engine == PORTFOLIO_VI ? conf->vi.memory : conf->kasi.memory;
+	if(report != NULL) report->add(mem, true); // the engines run at the same time on @mpg
+	if(run->winner != -1) return; // cancelled, or finished last
+	if(status != SOLVE_CONVERGED){ // both energies are below the least fixpoint
+		for(unsigned long u=0; u < size; u++) run->energy[u] = max(run->energy[u], energy[u]);
+		if(run->status != SOLVE_TIMEOUT) run->status = status;
+		return;
+	}
+	run->winner = engine;
+	run->seconds = chrono::duration<double>(chrono::steady_clock::now() - run->start).count();
+	copy(energy, energy + size, run->energy);
+	for(int e=0; e < PORTFOLIO_NUM_ENGINES; e++) __atomic_store_n(&run->cancel[e], true, __ATOMIC_RELAXED);
+}
+
+// waits for the engines of @run, forwarding the cancel flags of @conf to them
+static void portfolio_wait(const t_portfolio_conf& conf, t_portfolio_run* run){
+	const bool* cancel[PORTFOLIO_NUM_ENGINES] = {conf.vi.cancel, conf.kasi.cancel};
+	unique_lock<mutex> guard(run->lock);
+	while(run->running > 0){
+		if(cancel[PORTFOLIO_VI] == NULL && cancel[PORTFOLIO_KASI] == NULL) run->done.wait(guard);
+		else run->done.wait_for(guard, PORTFOLIO_POLL_PERIOD);
+		for(int e=0; e < PORTFOLIO_NUM_ENGINES; e++)
+			if(cancel[e] != NULL && __atomic_load_n(cancel[e], __ATOMIC_RELAXED))
+				__atomic_store_n(&run->cancel[e], true, __ATOMIC_RELAXED);
+	}
+}
+
+t_portfolio_result portfolio_compute_energy(MeanPayoffGame *mpg, t_nrg* energy, const t_portfolio_conf& conf){
+	assert(conf.workspace[PORTFOLIO_VI] == NULL || conf.workspace[PORTFOLIO_VI] != conf.workspace[PORTFOLIO_KASI]);
+	mpg->share(); // the engines only read @mpg from now on
+	t_portfolio_run run;
+	run.energy = energy;
+	fill_n(energy, mpg->get_n_0() + mpg->get_n_1(), 0);
+	run.start = chrono::steady_clock::now();
+	run.running = count(conf.engines, conf.engines + PORTFOLIO_NUM_ENGINES, true);
+	vector<thread> threads;
+	for(int e=0; e < PORTFOLIO_NUM_ENGINES; e++){
+		if(!conf.engines[e]) continue;
+		threads.push_back(thread([mpg, e, &conf, &run]{
+			portfolio_run(mpg, (t_portfolio_engine) e, &conf, &run);
+			lock_guard<mutex> guard(run.lock);
+			run.running--;
+			run.done.notify_one();
+		}));
+	}
+	portfolio_wait(conf, &run);
+	for(unsigned int i=0; i < threads.size(); i++) threads[i].join();
+	if(run.winner == -1 && run.status == SOLVE_CONVERGED) throw run.error != NULL ? run.error : "no portfolio engine";
+	t_portfolio_result result;
+	result.status = run.winner != -1 ? SOLVE_CONVERGED : run.status;
+	result.winner = run.winner != -1 ? (t_portfolio_engine) run.winner : PORTFOLIO_NUM_ENGINES;
+	result.seconds = run.winner != -1 ? run.seconds : chrono::duration<double>(chrono::steady_clock::now() - run.start).count();
+	result.n_0 = mpg->get_n_0();
+	result.n_1 = mpg->get_n_1();
+	result.m = mpg->get_e();
+	result.Top = mpg->get_Top();
+	result.min_weight = mpg->get_min_weight();
+	result.max_weight = mpg->get_max_weight();
+	result.max_deg = mpg->get_max_deg();
+	return result;
+}
+
+t_portfolio_engine portfolio_engine_from_string(const char* name){
+	for(int e=0; e < PORTFOLIO_NUM_ENGINES; e++)
+		if(string(name) == PORTFOLIO_ENGINE_NAMES[e]) return (t_portfolio_engine) e;
+	throw "unknown portfolio engine";
+}
+
+const char* portfolio_engine_name(t_portfolio_engine engine){
+	assert(engine < PORTFOLIO_NUM_ENGINES);
+	return PORTFOLIO_ENGINE_NAMES[engine];
+}
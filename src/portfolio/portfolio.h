@@ -0,0 +1,67 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Portfolio of energy solvers: the engines run on their own threads over the same
+*  game, which they only read, the first one to finish gives the energies and the
+*  others are cancelled through the cancel flag of their options. The cancel flags of
+*  @conf.vi and @conf.kasi are forwarded to their engine while they race. The winner is
+*  returned with the features of the game, to be logged for an engine selector. If
+*  every engine stops early at its deadline, the energies are the max of their
+*  energies, below the least fixpoint.
+*****************************************************************************************/
+
+#ifndef PORTFOLIO
+#define PORTFOLIO
+
+#include "../mpg/mpg.h"
+#include "../VI/VI.h"
+#include "../kasi/kasi.h"
+
+enum t_portfolio_engine{
+	PORTFOLIO_VI=0, // VI_compute_energy
+	PORTFOLIO_KASI, // KASI_lowerWeakUpperBound
+	PORTFOLIO_NUM_ENGINES
+};
+
+// options of portfolio_compute_energy
+struct t_portfolio_conf{
+	bool engines[PORTFOLIO_NUM_ENGINES] = {true, true}; // engines launched
+	t_vi_conf vi; // options of the VI engine, its workspace is ignored
+	t_kasi_conf kasi; // options of the KASI engine, its workspace is ignored, its strategy is valid only if KASI wins
+	SolverWorkspace* workspace[PORTFOLIO_NUM_ENGINES] = {NULL, NULL}; // distinct scratch buffers of each engine, NULL allocates them for the solve
+};
+
+// outcome of portfolio_compute_energy
+struct t_portfolio_result{
+	t_status status; // SOLVE_CONVERGED iff an engine finished
+	t_portfolio_engine winner; // valid if converged
+	double seconds; // wall time of the winner
+	// features of the game
+	unsigned long n_0, n_1, m;
+	t_nrg Top;
+	t_weight min_weight, max_weight;
+	unsigned long max_deg;
+};
+
+// returns the engine named @name ("vi", "kasi")
+t_portfolio_engine portfolio_engine_from_string(const char* name);
+const char* portfolio_engine_name(t_portfolio_engine engine);
+
+// energies of width t_nrg of @mpg, ULONG_MAX stands for \top, computed by the first
+// engine of @conf.engines to finish
+t_portfolio_result portfolio_compute_energy(MeanPayoffGame *mpg, t_nrg* energy, const t_portfolio_conf& conf = t_portfolio_conf());
+
+#endif
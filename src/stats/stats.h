@@ -0,0 +1,80 @@
+/*
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Operation counters of the solvers, compiled in with -DSOLVER_STATS=1 (make STATS=1).
+*  Every thread of a solve counts into its own t_solve_stats, which are added to the
+*  report of the options of the solve when it returns. Without SOLVER_STATS the
+*  STAT_ macros expand to nothing, and the reports stay zero.
+*****************************************************************************************/
+
+#ifndef STATS
+#define STATS
+
+#ifndef SOLVER_STATS
+#define SOLVER_STATS 0
+#endif
+
+enum t_stat{
+	// VI
+	STAT_VI_LIFTS=0, // lifts that raised an energy
+	STAT_VI_CIRCLE_OPS, // circle_op evaluations, of the lifts, of the counts and on the pre arcs
+	STAT_VI_PUSHES, // worklist pushes
+	STAT_VI_POPS, // worklist pops, one per lift operator
+	STAT_VI_COUNT_DECREMENTS, // decrements of count[] of the Max vertices
+	STAT_VI_TOP_SATURATIONS, // energies lifted to \top
+	// KASI
+	STAT_KASI_DIJKSTRAS, // Dijkstra runs, full or incremental
+	STAT_KASI_HEAP_PUSHES,
+	STAT_KASI_HEAP_POPS,
+	STAT_KASI_DECREASES, // decrease-key of the heap
+	STAT_KASI_RELAXATIONS, // in-arcs scanned from the popped vertices
+	STAT_KASI_BZ_ROUNDS, // update_Bz rounds
+	STAT_KASI_SWITCHES, // arcs switched by Min vertices
+	STAT_NUM_COUNTERS
+};
+
+inline const char* stat_name(t_stat stat){
+	static const char* names[STAT_NUM_COUNTERS] = {"vi_lifts", "vi_circle_ops", "vi_pushes", "vi_pops",
+		"vi_count_decrements", "vi_top_saturations", "kasi_dijkstras", "kasi_heap_pushes", "kasi_heap_pops",
+		"kasi_decreases", "kasi_relaxations", "kasi_bz_rounds", "kasi_switches"};
+	return names[stat];
+}
+
+/* the counters of a thread, aligned on a cache line so that
+   the counters of the threads do not share one */
+struct alignas(64) t_solve_stats{
+	unsigned long counter[STAT_NUM_COUNTERS];
+
+	t_solve_stats(){ clear(); }
+	void clear(){
+		for(int i=0; i < STAT_NUM_COUNTERS; i++) this->counter[i] = 0;
+	}
+	void add(const t_solve_stats& other){
+		for(int i=0; i < STAT_NUM_COUNTERS; i++) this->counter[i] += other.counter[i];
+	}
+};
+
+#if SOLVER_STATS
+#define STAT_ADD(stats, stat, k) ((stats).counter[stat] += (k))
+// adds the counters @local of a thread to the report @report of a solve, if not NULL
+#define STAT_REPORT(report, local) do{ if((report) != NULL) (report)->add(local); }while(0)
+#else
+#define STAT_ADD(stats, stat, k) ((void) 0)
+#define STAT_REPORT(report, local) ((void) 0)
+#endif
+#define STAT_INC(stats, stat) STAT_ADD(stats, stat, 1)
+
+#endif
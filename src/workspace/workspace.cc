@@ -0,0 +1,88 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include "workspace.h"
+
+#define WS_ALIGN 64
+
+SolverWorkspace::SolverWorkspace(){
+	for(int s=0; s < WS_NUM_SLOTS; s++){
+		this->blocks[s].addr = NULL;
+		this->blocks[s].bytes = 0;
+		this->blocks[s].mapped = false;
+	}
+}
+
+SolverWorkspace::~SolverWorkspace(){
+	release();
+}
+
+// returns the buffer of @slot, grown to @bytes if smaller, the old content is dropped
+void* SolverWorkspace::reserve(t_ws_slot slot, unsigned long bytes){
+	assert(slot < WS_NUM_SLOTS);
+	t_ws_block& b = this->blocks[slot];
+	if(bytes <= b.bytes && b.addr != NULL) return b.addr;
+	free_block(b);
+	if(bytes >= WS_HUGE_BYTES){
+		bytes = (bytes + WS_HUGE_BYTES - 1) / WS_HUGE_BYTES * WS_HUGE_BYTES;
+		void* addr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(addr == MAP_FAILED) throw "cannot allocate the solver workspace";
+		madvise(addr, bytes, MADV_HUGEPAGE); // a hint, ignored without transparent huge pages
+		b.mapped = true;
+		b.addr = addr;
+	}else{
+		bytes = (bytes + WS_ALIGN - 1) / WS_ALIGN * WS_ALIGN;
+		if(bytes == 0) bytes = WS_ALIGN;
+		b.addr = aligned_alloc(WS_ALIGN, bytes);
+		if(b.addr == NULL) throw "cannot allocate the solver workspace";
+		b.mapped = false;
+	}
+	b.bytes = bytes;
+	return b.addr;
+}
+
+void SolverWorkspace::free_block(t_ws_block& b){
+	if(b.addr == NULL) return;
+	if(b.mapped) munmap(b.addr, b.bytes);
+	else free(b.addr);
+	b.addr = NULL;
+	b.bytes = 0;
+	b.mapped = false;
+}
+
+void SolverWorkspace::release(){
+	for(int s=0; s < WS_NUM_SLOTS; s++) free_block(this->blocks[s]);
+}
+
+unsigned long SolverWorkspace::footprint(){
+	unsigned long bytes = 0;
+	for(int s=0; s < WS_NUM_SLOTS; s++) bytes += this->blocks[s].bytes;
+	return bytes;
+}
+
+unsigned long SolverWorkspace::footprint(t_ws_slot slot){
+	assert(slot < WS_NUM_SLOTS);
+	return this->blocks[slot].bytes;
+}
+
+unsigned long SolverWorkspace::huge_footprint(){
+	unsigned long bytes = 0;
+	for(int s=0; s < WS_NUM_SLOTS; s++)
+		if(this->blocks[s].mapped) bytes += this->blocks[s].bytes;
+	return bytes;
+}
@@ -0,0 +1,80 @@
+/* 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*****************************************************************************************
+*  Scratch buffers of the solvers. A SolverWorkspace owns one buffer per slot, which
+*  grows on demand and is kept across solves, so that repeated solves of games of the
+*  same size do not allocate. Buffers are 64-byte aligned, large ones are mmap'ed and
+*  advised to be backed by transparent huge pages. The content of a buffer is undefined
+*  when it is handed out, and a workspace is not shared by solvers running concurrently.
+*****************************************************************************************/
+
+#ifndef SOLVER_WORKSPACE
+#define SOLVER_WORKSPACE
+
+// per-vertex scratch buffers, the buffers of a solve are held by distinct slots
+enum t_ws_slot{
+	WS_ENERGY=0, // energies of the callers of the solvers
+	WS_ENERGY_CHECK, // energies of a second solver, to compare with WS_ENERGY
+	WS_ENERGY_NARROW, // 32-bit energies of the t_nrg solver wrappers
+	WS_STRATEGY, // Min's strategy certifying WS_ENERGY
+	WS_COUNT, // VI counters
+	WS_TOUCHED, // sequence numbers of the multi-threaded VI
+	WS_IN_LIST, // worklist membership
+	WS_LIST, // worklist stack, ring or links
+	WS_LIST2, // second ring of the two queue worklist
+	WS_KEY, // KASI Dijkstra keys
+	WS_PARENT, // KASI shortest path forest
+	WS_AFFECTED, // KASI incremental evaluation
+	WS_BZ, // KASI zero energy set
+	WS_S, // KASI vertices with finite energy
+	WS_BZ_COUNT, // KASI counters of the Max vertices of Bz
+	WS_PQ_KEY, // priority queue keys
+	WS_PQ_POS, // priority queue positions
+	WS_PQ_AUX, // priority queue heap or buckets
+	WS_NUM_SLOTS
+};
+
+// buffers of at least this size are mmap'ed and advised for huge pages
+#define WS_HUGE_BYTES (2UL << 20)
+
+class SolverWorkspace{
+	public:
+	SolverWorkspace();
+	~SolverWorkspace();
+	// buffer of @n elements of T in @slot, reallocated only if the slot is smaller
+	template<typename T> T* get(t_ws_slot slot, unsigned long n){
+		return (T*) reserve(slot, n * sizeof(T));
+	}
+	unsigned long footprint(); // bytes held by all the slots
+	unsigned long footprint(t_ws_slot slot); // bytes held by @slot
+	unsigned long huge_footprint(); // bytes of them in huge page advised mappings
+	void release(); // frees all the buffers
+
+	private:
+	struct t_ws_block{
+		void* addr;
+		unsigned long bytes;
+		bool mapped; // mmap'ed, else aligned_alloc'ed
+	};
+	t_ws_block blocks[WS_NUM_SLOTS];
+	void* reserve(t_ws_slot slot, unsigned long bytes);
+	static void free_block(t_ws_block& b);
+	// not copyable, the buffers are owned
+	SolverWorkspace(const SolverWorkspace&) = delete;
+	SolverWorkspace& operator=(const SolverWorkspace&) = delete;
+};
+
+#endif